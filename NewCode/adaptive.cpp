@@ -0,0 +1,101 @@
+#include "adaptive.h"
+
+#include <algorithm>
+#include <iostream>
+
+AdaptiveRunController::AdaptiveRunController(const StoppingRule& rule, bool antithetic_pairs)
+    : rule(rule), antithetic_pairs(antithetic_pairs), trials(0), met(false) {
+    // Pairs must never straddle a batch boundary, nor be cut short by the trial limit
+    if (this->antithetic_pairs && this->rule.batch_size % 2 == 1) {
+        this->rule.batch_size++;
+    }
+    if (this->antithetic_pairs && this->rule.max_trials % 2 == 1) {
+        this->rule.max_trials++;
+    }
+}
+
+std::vector<TrialResult> AdaptiveRunController::run(const std::function<std::vector<TrialResult>(int, int)>& run_batch) {
+    std::vector<TrialResult> all_results;
+
+    while (this->trials < this->rule.max_trials) {
+        int count = std::min(this->rule.batch_size, this->rule.max_trials - this->trials);
+        std::vector<TrialResult> batch = run_batch(this->trials, count);
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            bool second_of_pair = this->antithetic_pairs && i % 2 == 1;
+            this->add(batch[i], second_of_pair ? &batch[i - 1] : nullptr);
+        }
+        this->trials += static_cast<int>(batch.size());
+        all_results.insert(all_results.end(), batch.begin(), batch.end());
+
+        if (this->trials >= this->rule.min_trials && this->within_tolerance()) {
+            this->met = true;
+            break;
+        }
+    }
+    return all_results;
+}
+
+void AdaptiveRunController::add(const TrialResult& result, const TrialResult* pair_first) {
+    if (this->antithetic_pairs && !pair_first) {
+        return;  // first half of a pair, folded in together with its mirror
+    }
+
+    // Every trial runs the same population, so indices line up across trials and pairs
+    this->ids = result.ids;
+    if (this->stats.size() < result.humans.size()) {
+        this->stats.resize(result.humans.size(), std::vector<RunningStats>(NUM_METRICS));
+    }
+    for (size_t i = 0; i < result.humans.size(); ++i) {
+        std::vector<RunningStats>& per_metric = this->stats[i];
+
+        for (int m = 0; m < NUM_METRICS; ++m) {
+            double value = result.weight * metric_value(result.humans[i], static_cast<Metric>(m));
+            if (pair_first) {
+                double mirrored = i < pair_first->humans.size()
+                    ? pair_first->weight * metric_value(pair_first->humans[i], static_cast<Metric>(m)) : 0.0;
+                value = 0.5 * (value + mirrored);
+            }
+            per_metric[m].add(value);
+        }
+    }
+}
+
+double AdaptiveRunController::half_width(int human, Metric m) const {
+    if (human < 0 || human >= static_cast<int>(this->stats.size())) return 0.0;
+    return this->rule.confidence_z * this->stats[human][static_cast<int>(m)].standard_error();
+}
+
+bool AdaptiveRunController::within_tolerance() const {
+    for (size_t i = 0; i < this->stats.size(); ++i) {
+        for (int m = 0; m < NUM_METRICS; ++m) {
+            if (this->half_width(static_cast<int>(i), static_cast<Metric>(m)) > this->rule.tolerance[m]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int AdaptiveRunController::trials_used() const {
+    return this->trials;
+}
+
+bool AdaptiveRunController::converged() const {
+    return this->met;
+}
+
+void AdaptiveRunController::print_report() const {
+    std::cout << "Adaptive stopping: " << this->trials << " trials used ("
+              << (this->met ? "all tolerances met" : "max_trials reached before tolerances were met")
+              << ")" << std::endl;
+    for (size_t i = 0; i < this->stats.size(); ++i) {
+        int id = (*this->ids)[i];
+        for (int m = 0; m < NUM_METRICS; ++m) {
+            double hw = this->half_width(static_cast<int>(i), static_cast<Metric>(m));
+            std::cout << "  " << METRIC_NAMES[m] << " [human " << id << "]: +/- " << hw
+                      << " (tolerance " << this->rule.tolerance[m] << ")"
+                      << (hw > this->rule.tolerance[m] ? "  NOT MET" : "") << std::endl;
+        }
+    }
+}
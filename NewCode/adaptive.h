@@ -0,0 +1,45 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "simulator.h"
+#include "stats.h"
+
+// When to stop adding trials: every metric of every human must have a confidence
+// interval half-width (z * standard error) at or below its tolerance.
+struct StoppingRule {
+    double tolerance[NUM_METRICS];
+    double confidence_z = 1.96;
+    int batch_size = 50;
+    int min_trials = 100;
+    int max_trials = 100000;
+};
+
+class AdaptiveRunController {
+public:
+    AdaptiveRunController(const StoppingRule& rule, bool antithetic_pairs);
+
+    // Calls run_batch(first_trial, count) until the rule is met or max_trials is reached
+    std::vector<TrialResult> run(const std::function<std::vector<TrialResult>(int, int)>& run_batch);
+
+    int trials_used() const;
+    bool converged() const;
+    double half_width(int human, Metric m) const;  // human is a dense index (see TrialResult)
+    void print_report() const;
+
+private:
+    StoppingRule rule;
+    bool antithetic_pairs;
+    int trials;
+    bool met;
+    // Per human (dense index): per-metric stats over trials (or over antithetic pair means)
+    std::vector<std::vector<RunningStats>> stats;
+    std::shared_ptr<const std::vector<int>> ids;  // external ids, for the report
+
+    void add(const TrialResult& result, const TrialResult* pair_first);
+    bool within_tolerance() const;
+};
+
+#endif //adaptive
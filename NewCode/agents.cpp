@@ -21,8 +21,8 @@ static std::string HumanStatusToString(HumanStatus s) {
 }
 
 
-HumanContactRecord::HumanContactRecord(int other_id, HumanStatus other_status, int start_time, float total_proximity, int end_time)
-: other_id(other_id),
+HumanContactRecord::HumanContactRecord(int other, HumanStatus other_status, int start_time, float total_proximity, int end_time)
+: other(other),
   other_status(other_status),
   start_time(start_time),
   total_proximity(total_proximity),
@@ -42,7 +42,7 @@ float HumanContactRecord::average_proximity() const {
 
 std::string HumanContactRecord::__repr__() const {
     std::ostringstream oss;
-    oss << "(other_id=" << this->other_id
+    oss << "(other=" << this->other
         << ", other_status=" << HumanStatusToString(this->other_status)
         << ", start=" << this->start_time
         << ", duration=" << this->duration()
@@ -52,7 +52,7 @@ std::string HumanContactRecord::__repr__() const {
 }
 
 
-HumanSicknessRecord::HumanSicknessRecord(int start_time, user::InfectionModel* start_infection_model, float p_zoonotic, int end_time, int secondary_cases)
+HumanSicknessRecord::HumanSicknessRecord(int start_time, const user::InfectionModel& start_infection_model, float p_zoonotic, int end_time, int secondary_cases)
 : start_time(start_time),
   start_infection_model(start_infection_model),
   p_zoonotic(p_zoonotic),
@@ -63,12 +63,8 @@ HumanSicknessRecord::HumanSicknessRecord(int start_time, user::InfectionModel* s
 
 std::string HumanSicknessRecord::__repr__() const {
     std::ostringstream oss;
-    float animal_hazard = 0.0f;
-    float human_hazard = 0.0f;
-    if (this->start_infection_model) {
-        animal_hazard = this->start_infection_model->experienced_animal_hazard;
-        human_hazard  = this->start_infection_model->experienced_human_hazard;
-    }
+    float animal_hazard = this->start_infection_model.experienced_animal_hazard;
+    float human_hazard  = this->start_infection_model.experienced_human_hazard;
 
     oss << "(p_zoonotic=" << this->p_zoonotic
         << ", start=" << this->start_time
@@ -80,61 +76,47 @@ std::string HumanSicknessRecord::__repr__() const {
     return oss.str();
 }
 
+KeyframePath::KeyframePath(const std::map<int, LocationRecord>& keyframes) {
+    this->segments.reserve(keyframes.size());
+    for (auto it = keyframes.begin(); it != keyframes.end(); ++it) {
+        auto next = std::next(it);
+        PathSegment seg{it->first, PATH_END, it->second, it->second, 0.0f, 0.0f};
+        if (next != keyframes.end()) {
+            float dt = static_cast<float>(next->first - it->first);
+            seg.end_time = next->first;
+            seg.end = next->second;
+            seg.vx = (next->second.x - it->second.x) / dt;
+            seg.vy = (next->second.y - it->second.y) / dt;
+        }
+        this->segments.push_back(seg);
+    }
+}
+
+const PathSegment* KeyframePath::seek(int t) {
+    if (this->segments.empty()) return nullptr;
+    // Rewind if time went backwards (e.g. a restored checkpoint); otherwise just step forward
+    if (this->segments[this->cursor].start_time > t) this->cursor = 0;
+    while (this->segments[this->cursor].end_time <= t) {
+        this->cursor++;
+    }
+    return &this->segments[this->cursor];
+}
+
 AnimalPresence::AnimalPresence(int id, const std::map<int, LocationRecord>& migration_pattern, float radius, float hazard_rate)
 : id(id),
   migration_pattern(migration_pattern),
+  migration_path(migration_pattern),
   location(),
   radius(radius),
-  infection_model(nullptr)
+  infection_model(hazard_rate, 0.0f, 0.0f),
+  home(),
+  heading(0.0f)
 {
     if (!this->migration_pattern.empty()) {
         auto it = this->migration_pattern.begin();
         this->location = it->second;
     }
-
-    this->infection_model = new user::InfectionModel(hazard_rate, 0.0f, 0.0f);
-}
-
-AnimalPresence::AnimalPresence(const AnimalPresence& other)
-    : id(other.id),
-      migration_pattern(other.migration_pattern),
-      location(other.location),
-      radius(other.radius),
-      infection_model(nullptr)
-{
-    if (other.infection_model) {
-        this->infection_model = new user::InfectionModel(*other.infection_model);
-    }
-}
-
-Human::Human(const Human& other)
-    : id(other.id),
-      location_history(other.location_history),
-      self_reports(other.self_reports),
-      location(other.location),
-      status(other.status),
-      prev_status(other.prev_status),
-      contact_network(other.contact_network),
-      sickness_records(other.sickness_records),
-      active_contacts(other.active_contacts),
-      infection_model(nullptr)
-{
-    // Deep copy the infection_model pointer
-    if (other.infection_model) {
-        this->infection_model = new user::InfectionModel(*other.infection_model);
-    }
-}
-
-
-void AnimalPresence::move(Simulation* sim) {
-    if (!sim) return;
-
-    auto it = this->migration_pattern.find(sim->time_step);
-    if (it != this->migration_pattern.end()) {
-        this->location = it->second;
-    } else {
-        user::animal_motion(this);
-    }
+    this->home = this->location;
 }
 
 void AnimalPresence::update(Simulation* sim) {
@@ -143,7 +125,9 @@ void AnimalPresence::update(Simulation* sim) {
 
 Human::Human(int id, const std::map<int, LocationRecord>& location_history, const std::map<int, HumanStatus>& reports)
 : id(id),
+  index(-1),
   location_history(location_history),
+  location_path(location_history),
   self_reports(reports),
   location(),
   status(HumanStatus::HEALTHY),
@@ -151,7 +135,13 @@ Human::Human(int id, const std::map<int, LocationRecord>& location_history, cons
   contact_network(),
   sickness_records(),
   active_contacts(),
-  infection_model(nullptr)
+  infection_model(0.0f, 0.0f, 0.0f),
+  heading(0.0f),
+  evicted_contacts(0),
+  evicted_sickness_records(0),
+  evicted_secondary_cases(0),
+  pending_log_likelihood_ratio(0.0),
+  pending_contact_events()
 {
     if (!this->location_history.empty()) {
         auto it = this->location_history.begin();
@@ -160,110 +150,6 @@ Human::Human(int id, const std::map<int, LocationRecord>& location_history, cons
         this->location.x = 0.0f;
         this->location.y = 0.0f;
     }
-
-    this->infection_model = new user::InfectionModel(0.0f, 0.0f, 0.0f);
-}
-
-void Human::move(Simulation* sim) {
-    if (!sim) return;
-
-    auto it = this->location_history.find(sim->time_step);
-    if (it != this->location_history.end()) {
-        this->location = it->second;
-    } else {
-        user::human_motion(this, sim->time_step);
-    }
-
-    auto rit = this->self_reports.find(sim->time_step);
-    if (rit != this->self_reports.end()) {
-        this->status = rit->second;
-    }
-}
-
-void Human::update(Simulation* sim) {
-    if (!sim) return;
-
-    std::vector<AnimalPresence*> current_animal_contacts;
-    current_animal_contacts.reserve(sim->animal_agents.size());
-    for (AnimalPresence* animal : sim->animal_agents) {
-        if (!animal) continue;
-        float dx = this->location.x - animal->location.x;
-        float dy = this->location.y - animal->location.y;
-        float dist = std::sqrt(dx * dx + dy * dy);
-        if (dist <= animal->radius) {
-            current_animal_contacts.push_back(animal);
-        }
-    }
-
-    for (const auto& kv : sim->human_agents) {
-        Human* human = kv.second;
-        if (!human) continue;
-        if (human->id == this->id) continue;
-
-        float dx = this->location.x - human->location.x;
-        float dy = this->location.y - human->location.y;
-        float dist = std::sqrt(dx * dx + dy * dy);
-
-        if (dist <= CONTACT_NETWORK_PROXIMITY_THRESHOLD) {
-            auto act_it = this->active_contacts.find(human->id);
-            if (act_it != this->active_contacts.end()) {
-                act_it->second.total_proximity += dist;
-            } else {
-                HumanContactRecord record(human->id, human->status, sim->time_step, dist);
-                this->active_contacts[human->id] = record;
-            }
-        } else {
-            auto act_it = this->active_contacts.find(human->id);
-            if (act_it != this->active_contacts.end()) {
-                HumanContactRecord record = act_it->second;
-                this->active_contacts.erase(act_it);
-                record.end_time = sim->time_step;
-                this->contact_network[record.start_time] = record;
-            }
-        }
-    }
-
-    std::vector<Human*> current_human_contacts;
-    current_human_contacts.reserve(this->active_contacts.size());
-    for (const auto& kv : this->active_contacts) {
-        int hid = kv.first;
-        auto hit = sim->human_agents.find(hid);
-        if (hit != sim->human_agents.end()) {
-            current_human_contacts.push_back(hit->second);
-        }
-    }
-
-    bool got_sick = user::infection_probability_model(this, current_animal_contacts, current_human_contacts);
-
-    if (got_sick && this->status != HumanStatus::SICK) {
-        this->status = HumanStatus::SICK;
-    }
-
-    if (this->status == HumanStatus::SICK) {
-        if (this->prev_status == HumanStatus::HEALTHY) {
-            user::InfectionModel* copied_model = nullptr;
-            if (this->infection_model) {
-                copied_model = new user::InfectionModel(*this->infection_model);
-            } else {
-                copied_model = new user::InfectionModel(0.0f, 0.0f, 0.0f);
-            }
-
-            HumanSicknessRecord record(sim->time_step, copied_model);
-            this->sickness_records.push_back(record);
-        }
-
-        int sec_cases = this->secondary_cases(sim);
-        if (!this->sickness_records.empty()) {
-            this->sickness_records.back().secondary_cases = sec_cases;
-            this->sickness_records.back().p_zoonotic = user::zoonotic_probability_model(&this->sickness_records.back());
-        }
-    } else if (this->status == HumanStatus::HEALTHY && this->prev_status == HumanStatus::SICK) {
-        if (!this->sickness_records.empty()) {
-            this->sickness_records.back().end_time = sim->time_step;
-        }
-    }
-
-    this->prev_status = this->status;
 }
 
 int Human::secondary_cases(Simulation* sim) {
@@ -277,20 +163,11 @@ int Human::secondary_cases(Simulation* sim) {
     for (const auto& kv : this->contact_network) {
         const HumanContactRecord& c = kv.second;
         if (c.start_time >= infectious_at) {
-            auto other_it = sim->human_agents.find(c.other_id);
-            if (other_it == sim->human_agents.end()) continue;
-            Human* other = other_it->second;
-            bool incremented = false;
-
-            for (const HumanSicknessRecord& sickness : other->sickness_records) {
-                if (sickness.start_time >= infectious_at && c.other_status == HumanStatus::HEALTHY) {
-                    secondary_cases_count += 1;
-                    incremented = true;
-                    break;
-                }
-            }
-
-            if (incremented) {
+            // Other humans' records as of the start of this tick; onsets are ascending, so
+            // the latest one tells whether any falls in the window
+            const HumanTickState& other = sim->published_state(c.other);
+            if (other.last_onset >= infectious_at && c.other_status == HumanStatus::HEALTHY) {
+                secondary_cases_count += 1;
                 break;
             }
         }
@@ -9,13 +9,18 @@
 #include <stdexcept>
 #include <algorithm>
 #include <memory>
+#include <climits>
 #include "user.h"
 #include "simulator.h"
+#include "flat_map.h"
 
 namespace user {
     class InfectionModel;
 }
 
+extern float CONTACT_NETWORK_PROXIMITY_THRESHOLD;
+extern int INCUBATION_SIM_TIME;
+
 enum class HumanStatus {
     HEALTHY = 0,
     SICK = 1
@@ -27,16 +32,44 @@ public:
     float y;
 };
 
+// One leg of a piecewise-linear keyframed path, with its per-tick velocity precomputed.
+// The leg after the last keyframe never ends and has zero velocity.
+struct PathSegment {
+    int start_time;
+    int end_time;
+    LocationRecord start;
+    LocationRecord end;
+    float vx;
+    float vy;
+};
+
+const int PATH_END = INT_MAX;
+
+// Keyframed path with a cursor on the current segment. Ticks only move forward, so seeking
+// the segment for the current tick is amortized O(1) instead of a map lookup or scan.
+class KeyframePath {
+public:
+    std::vector<PathSegment> segments;
+    size_t cursor = 0;
+
+    KeyframePath() = default;
+    explicit KeyframePath(const std::map<int, LocationRecord>& keyframes);
+
+    // Segment with end_time > t: the one containing t, or the first segment if t is before
+    // the first keyframe. nullptr if there are no keyframes.
+    const PathSegment* seek(int t);
+};
+
 class HumanContactRecord {
 public:
-    int other_id;
+    int other;  // dense index of the other human (see Simulation::human_order)
     HumanStatus other_status;  
     int start_time;
     float total_proximity;
     int end_time;
 
     HumanContactRecord() = default;
-    HumanContactRecord(int other_id, HumanStatus other_status, int start_time, float total_proximity, int end_time = -1);
+    HumanContactRecord(int other, HumanStatus other_status, int start_time, float total_proximity, int end_time = -1);
 
     int duration() const;
     float average_proximity() const;
@@ -46,12 +79,12 @@ public:
 class HumanSicknessRecord {
 public:
     int start_time;
-    user::InfectionModel* start_infection_model;
+    user::InfectionModel start_infection_model;  // infection state at onset, stored by value
     float p_zoonotic;
     int end_time;
     int secondary_cases;
     HumanSicknessRecord() = default;
-    HumanSicknessRecord(int start_time, user::InfectionModel* start_infection_model, float p_zoonotic = 0, int end_time = -1, int secondary_cases = 0);
+    HumanSicknessRecord(int start_time, const user::InfectionModel& start_infection_model, float p_zoonotic = 0, int end_time = -1, int secondary_cases = 0);
 
     std::string __repr__() const;
 };
@@ -60,36 +93,50 @@ class AnimalPresence {
 public:
     int id;
     std::map<int, LocationRecord> migration_pattern;
+    KeyframePath migration_path;  // migration_pattern as interpolation segments
     LocationRecord location;
     float radius;
-    user::InfectionModel* infection_model;
+    user::InfectionModel infection_model;
+    LocationRecord home;  // centre of the home range (first keyframe)
+    float heading;        // motion state carried between ticks (see motion.h)
 
     AnimalPresence(int id, const std::map<int, LocationRecord>& migration_pattern, float radius, float hazard_rate);
-    AnimalPresence(const AnimalPresence& other);
-    void move(Simulation* sim);
     void update(Simulation* sim);
 };
 
 class Human {
 public:
     int id;
+    int index;  // dense index, -1 until the simulation indexes its population (see index_humans)
     std::map<int, LocationRecord> location_history;   
+    KeyframePath location_path;  // location_history as interpolation segments
     std::map<int, HumanStatus> self_reports;          
 
     LocationRecord location;
     HumanStatus status;
     HumanStatus prev_status;
 
-    std::map<int, HumanContactRecord> contact_network;  
+    // Per-trial history lives in flat containers, whose capacity survives a reset (see restore)
+    FlatMap<int, HumanContactRecord> contact_network;  // closed contacts keyed by start time
     std::vector<HumanSicknessRecord> sickness_records;
-    std::map<int, HumanContactRecord> active_contacts;  
+    FlatMap<int, HumanContactRecord> active_contacts;  // open contacts keyed by the other human's index
 
-    user::InfectionModel* infection_model;
+    user::InfectionModel infection_model;
+    float heading;  // motion state carried between ticks (see motion.h)
+
+    // History pruned out of the analysis window in long-horizon mode (see history.h)
+    long evicted_contacts;
+    int evicted_sickness_records;
+    int evicted_secondary_cases;
+
+    // Outputs of this tick's update that touch shared state; folded into the simulation in
+    // human_agents order once every human has updated (see commit_human_updates)
+    double pending_log_likelihood_ratio;
+    std::vector<ContactEvent> pending_contact_events;
 
     Human(int id, const std::map<int, LocationRecord>& location_history, const std::map<int, HumanStatus>& reports);
-    Human(const Human& other);
-    void move(Simulation* sim);
-    void update(Simulation* sim);
+    // 1 if some contact met healthy since INCUBATION_SIM_TIME before the current onset has
+    // fallen sick since then, else 0; the input of the zoonotic probability model
     int secondary_cases(Simulation* sim);
 };
 
@@ -0,0 +1,132 @@
+#include "alloc_tracking.h"
+
+#ifdef TRACK_ALLOCATIONS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// Every block carries its size in a header, padded to keep max_align_t alignment
+static const size_t HEADER_SIZE = alignof(std::max_align_t);
+
+static std::atomic<long> total_allocations(0);
+static std::atomic<long> total_frees(0);
+static std::atomic<long> live_bytes(0);
+static std::atomic<long> peak_bytes(0);
+static thread_local long thread_net = 0;
+static thread_local long thread_allocs = 0;
+
+static void count_alloc(size_t size) {
+    total_allocations.fetch_add(1, std::memory_order_relaxed);
+    long live = live_bytes.fetch_add(static_cast<long>(size), std::memory_order_relaxed) + static_cast<long>(size);
+    long peak = peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    thread_net++;
+    thread_allocs++;
+}
+
+static void count_free(size_t size) {
+    total_frees.fetch_add(1, std::memory_order_relaxed);
+    live_bytes.fetch_sub(static_cast<long>(size), std::memory_order_relaxed);
+    thread_net--;
+}
+
+// nullptr on failure; the throwing operators turn that into bad_alloc
+static void* tracked_alloc(size_t size) {
+    void* raw = std::malloc(size + HEADER_SIZE);
+    if (!raw) return nullptr;
+    *static_cast<size_t*>(raw) = size;
+    count_alloc(size);
+    return static_cast<char*>(raw) + HEADER_SIZE;
+}
+
+static void tracked_free(void* p) {
+    if (!p) return;
+    void* raw = static_cast<char*>(p) - HEADER_SIZE;
+    count_free(*static_cast<size_t*>(raw));
+    std::free(raw);
+}
+
+// Over-aligned blocks: the header sits right below the aligned address and also records
+// where the malloc'd block starts
+struct AlignedHeader {
+    size_t size;
+    void* raw;
+};
+
+static void* tracked_alloc_aligned(size_t size, std::align_val_t align) {
+    size_t a = static_cast<size_t>(align);
+    void* raw = std::malloc(size + a + sizeof(AlignedHeader));
+    if (!raw) return nullptr;
+    uintptr_t first = reinterpret_cast<uintptr_t>(raw) + sizeof(AlignedHeader);
+    char* p = reinterpret_cast<char*>((first + a - 1) / a * a);
+    AlignedHeader* header = reinterpret_cast<AlignedHeader*>(p) - 1;
+    header->size = size;
+    header->raw = raw;
+    count_alloc(size);
+    return p;
+}
+
+static void tracked_free_aligned(void* p) {
+    if (!p) return;
+    AlignedHeader* header = static_cast<AlignedHeader*>(p) - 1;
+    count_free(header->size);
+    std::free(header->raw);
+}
+
+static void* checked(void* p) {
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size) { return checked(tracked_alloc(size)); }
+void* operator new[](size_t size) { return checked(tracked_alloc(size)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size); }
+void operator delete(void* p) noexcept { tracked_free(p); }
+void operator delete[](void* p) noexcept { tracked_free(p); }
+void operator delete(void* p, size_t) noexcept { tracked_free(p); }
+void operator delete[](void* p, size_t) noexcept { tracked_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { tracked_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { tracked_free(p); }
+
+void* operator new(size_t size, std::align_val_t align) { return checked(tracked_alloc_aligned(size, align)); }
+void* operator new[](size_t size, std::align_val_t align) { return checked(tracked_alloc_aligned(size, align)); }
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return tracked_alloc_aligned(size, align); }
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return tracked_alloc_aligned(size, align); }
+void operator delete(void* p, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { tracked_free_aligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { tracked_free_aligned(p); }
+
+AllocationCounters allocation_counters() {
+    AllocationCounters c;
+    c.allocations = total_allocations.load();
+    c.frees = total_frees.load();
+    c.live_bytes = live_bytes.load();
+    c.peak_bytes = peak_bytes.load();
+    return c;
+}
+
+long thread_net_allocations() {
+    return thread_net;
+}
+
+long thread_allocations() {
+    return thread_allocs;
+}
+
+void print_allocation_report() {
+    AllocationCounters c = allocation_counters();
+    std::cout << "Allocations: " << c.allocations << " allocated, " << c.frees << " freed, "
+              << (c.allocations - c.frees) << " live (" << c.live_bytes << " bytes), peak "
+              << c.peak_bytes << " bytes" << std::endl;
+}
+
+#endif
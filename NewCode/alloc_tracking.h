@@ -0,0 +1,49 @@
+#ifndef ALLOC_TRACKING_H
+#define ALLOC_TRACKING_H
+
+// Allocation and leak accounting. Build with -DTRACK_ALLOCATIONS to replace the global
+// operator new/delete with counting versions; otherwise everything here compiles to nothing.
+
+struct AllocationCounters {
+    long allocations = 0;
+    long frees = 0;
+    long live_bytes = 0;
+    long peak_bytes = 0;
+};
+
+#ifdef TRACK_ALLOCATIONS
+
+AllocationCounters allocation_counters();
+// Net allocations (allocations - frees) made by the calling thread so far
+long thread_net_allocations();
+// Allocations made by the calling thread so far
+long thread_allocations();
+void print_allocation_report();
+
+// Counts heap blocks allocated (and allocated but not freed) by this thread since construction
+class AllocationScope {
+public:
+    AllocationScope() : start(thread_net_allocations()), start_allocations(thread_allocations()) {}
+    long net_allocations() const { return thread_net_allocations() - start; }
+    long allocations() const { return thread_allocations() - start_allocations; }
+private:
+    long start;
+    long start_allocations;
+};
+
+#else
+
+inline AllocationCounters allocation_counters() { return AllocationCounters(); }
+inline long thread_net_allocations() { return 0; }
+inline long thread_allocations() { return 0; }
+inline void print_allocation_report() {}
+
+class AllocationScope {
+public:
+    long net_allocations() const { return 0; }
+    long allocations() const { return 0; }
+};
+
+#endif
+
+#endif //alloc_tracking
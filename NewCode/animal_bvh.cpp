@@ -0,0 +1,163 @@
+#include "animal_bvh.h"
+#include "agents.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Exact containment test, identical to the brute-force pass so results are bit-identical
+static inline bool in_circle(float x, float y, const AnimalPresence& a) {
+    float dx = x - a.location.x;
+    float dy = y - a.location.y;
+    return std::sqrt(dx * dx + dy * dy) <= a.radius;
+}
+
+bool AnimalBVH::refresh(const std::vector<std::unique_ptr<AnimalPresence>>& animals) {
+    if (this->circles.size() != animals.size() || this->nodes.empty() != animals.empty()) {
+        this->build(animals);
+        return true;
+    }
+
+    // Refit the leaves of animals that moved or resized, then their ancestors
+    bool refitted = false;
+    for (size_t i = 0; i < animals.size(); i++) {
+        const AnimalPresence& a = *animals[i];
+        Circle c{a.location.x, a.location.y, a.radius};
+        Circle& old = this->circles[i];
+        if (c.x == old.x && c.y == old.y && c.radius == old.radius) continue;
+
+        old = c;
+        int node = this->leaf_of[i];
+        this->fit_leaf(node);
+        for (int p = this->nodes[node].parent; p >= 0; p = this->nodes[p].parent) {
+            const Box& l = this->nodes[this->nodes[p].left].box;
+            const Box& r = this->nodes[this->nodes[p].right].box;
+            this->nodes[p].box = {std::min(l.min_x, r.min_x), std::min(l.min_y, r.min_y),
+                                  std::max(l.max_x, r.max_x), std::max(l.max_y, r.max_y)};
+        }
+        refitted = true;
+        this->refits++;
+    }
+
+    if (refitted && this->total_area() > 2.0f * this->built_area) {
+        this->build(animals);
+        return true;
+    }
+    return false;
+}
+
+void AnimalBVH::build(const std::vector<std::unique_ptr<AnimalPresence>>& animals) {
+    int n = static_cast<int>(animals.size());
+    this->circles.resize(n);
+    this->leaf_of.resize(n);
+    this->order.resize(n);
+    for (int i = 0; i < n; i++) {
+        const AnimalPresence& a = *animals[i];
+        this->circles[i] = {a.location.x, a.location.y, a.radius};
+        this->order[i] = i;
+    }
+
+    this->nodes.clear();
+    if (n > 0) {
+        this->nodes.reserve(2 * (n / LEAF_SIZE + 1));
+        this->build_node(0, n, -1);
+    }
+    this->built_area = this->total_area();
+    this->rebuilds++;
+}
+
+// Top-down median split on the longer axis of the circle centres
+int AnimalBVH::build_node(int first, int count, int parent) {
+    int index = static_cast<int>(this->nodes.size());
+    this->nodes.push_back({{0, 0, 0, 0}, parent, -1, -1, first, count});
+
+    if (count <= LEAF_SIZE) {
+        for (int k = first; k < first + count; k++) {
+            this->leaf_of[this->order[k]] = index;
+        }
+        this->fit_leaf(index);
+        return index;
+    }
+
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    for (int k = first; k < first + count; k++) {
+        const Circle& c = this->circles[this->order[k]];
+        min_x = std::min(min_x, c.x); max_x = std::max(max_x, c.x);
+        min_y = std::min(min_y, c.y); max_y = std::max(max_y, c.y);
+    }
+    bool split_x = max_x - min_x >= max_y - min_y;
+
+    int half = count / 2;
+    auto begin = this->order.begin() + first;
+    std::nth_element(begin, begin + half, begin + count, [&](int a, int b) {
+        return split_x ? this->circles[a].x < this->circles[b].x : this->circles[a].y < this->circles[b].y;
+    });
+
+    int left = this->build_node(first, half, index);
+    int right = this->build_node(first + half, count - half, index);
+
+    const Box& l = this->nodes[left].box;
+    const Box& r = this->nodes[right].box;
+    Node& node = this->nodes[index];
+    node.left = left;
+    node.right = right;
+    node.box = {std::min(l.min_x, r.min_x), std::min(l.min_y, r.min_y),
+                std::max(l.max_x, r.max_x), std::max(l.max_y, r.max_y)};
+    return index;
+}
+
+void AnimalBVH::fit_leaf(int index) {
+    Node& node = this->nodes[index];
+    Box box{INFINITY, INFINITY, -INFINITY, -INFINITY};
+    for (int k = node.first; k < node.first + node.count; k++) {
+        const Circle& c = this->circles[this->order[k]];
+        // Padded so float rounding in the exact test can never accept a point outside the box
+        float r = c.radius + 0.01f + 1e-5f * (std::fabs(c.x) + std::fabs(c.y) + c.radius);
+        box.min_x = std::min(box.min_x, c.x - r);
+        box.min_y = std::min(box.min_y, c.y - r);
+        box.max_x = std::max(box.max_x, c.x + r);
+        box.max_y = std::max(box.max_y, c.y + r);
+    }
+    node.box = box;
+}
+
+float AnimalBVH::total_area() const {
+    float sum = 0.0f;
+    for (const Node& node : this->nodes) {
+        sum += node.box.area();
+    }
+    return sum;
+}
+
+void AnimalBVH::contacts(float x, float y, const std::vector<std::unique_ptr<AnimalPresence>>& animals,
+                         std::vector<int>& out) const {
+    if (this->nodes.empty()) return;
+
+    // Hits come out in tree order; they're sorted back to animal order so hazard sums match
+    // the other contact finders bit for bit. Scratch is per thread and keeps its capacity.
+    thread_local std::vector<int> hits;
+    thread_local std::vector<int> stack;
+    hits.clear();
+    stack.clear();
+    stack.push_back(0);
+
+    while (!stack.empty()) {
+        const Node& node = this->nodes[stack.back()];
+        stack.pop_back();
+        if (x < node.box.min_x || x > node.box.max_x || y < node.box.min_y || y > node.box.max_y) continue;
+
+        if (node.left < 0) {
+            for (int k = node.first; k < node.first + node.count; k++) {
+                const AnimalPresence& a = *animals[this->order[k]];
+                if (a.infection_model.output_hazard != 0.0f && in_circle(x, y, a)) {
+                    hits.push_back(this->order[k]);
+                }
+            }
+        } else {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+
+    std::sort(hits.begin(), hits.end());
+    out.insert(out.end(), hits.begin(), hits.end());
+}
@@ -0,0 +1,60 @@
+#ifndef ANIMAL_BVH_H
+#define ANIMAL_BVH_H
+
+#include <memory>
+#include <vector>
+
+class AnimalPresence;
+
+// Bounding-volume hierarchy over the animal circles (axis-aligned boxes, up to
+// LEAF_SIZE animals per leaf). Suited to many overlapping presences with very different
+// radii, where a fixed raster either gets coarse or huge. Moving animals are handled by
+// refitting the boxes on their path to the root; the tree is rebuilt from scratch only
+// when refits have degraded it (total box area doubled) or the population changed.
+class AnimalBVH {
+public:
+    // Bring the tree up to date with the animals' current circles; returns true if it rebuilt
+    bool refresh(const std::vector<std::unique_ptr<AnimalPresence>>& animals);
+
+    // Append the animal_agents indices of the animals whose circle contains (x, y), ascending.
+    // Animals with zero hazard are never reported, matching HazardField::contacts.
+    void contacts(float x, float y, const std::vector<std::unique_ptr<AnimalPresence>>& animals,
+                  std::vector<int>& out) const;
+
+    long rebuilds = 0;
+    long refits = 0;
+
+private:
+    static const int LEAF_SIZE = 4;
+
+    struct Box {
+        float min_x, min_y, max_x, max_y;
+        float area() const { return (this->max_x - this->min_x) * (this->max_y - this->min_y); }
+    };
+
+    struct Node {
+        Box box;
+        int parent;
+        int left;    // child node index, or -1 for a leaf
+        int right;
+        int first;   // leaf: range [first, first + count) of order
+        int count;
+    };
+
+    struct Circle {
+        float x, y, radius;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int> order;       // animal indices grouped by leaf
+    std::vector<int> leaf_of;     // animal index -> leaf node
+    std::vector<Circle> circles;  // circles the boxes were fitted to
+    float built_area = 0.0f;
+
+    void build(const std::vector<std::unique_ptr<AnimalPresence>>& animals);
+    int build_node(int first, int count, int parent);
+    void fit_leaf(int node);
+    float total_area() const;
+};
+
+#endif //animal_bvh
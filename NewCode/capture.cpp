@@ -0,0 +1,186 @@
+#include "capture.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+#ifdef CAPTURE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace fs = std::filesystem;
+
+FrameEncoder::FrameEncoder(const std::string& out_dir, CaptureFormat format)
+    : out_dir(out_dir), format(format), stop_requested(false), written(0) {
+    fs::create_directories(out_dir);
+    if (format == CaptureFormat::RAW_VIDEO) {
+        raw_out.open(out_dir + "/frames.rgb", std::ios::binary);
+        if (!raw_out) {
+            std::cerr << "Capture: could not open " << out_dir << "/frames.rgb" << std::endl;
+        }
+    }
+    encoder_thread = std::thread(&FrameEncoder::encoder_loop, this);
+}
+
+FrameEncoder::~FrameEncoder() {
+    finish();
+}
+
+CapturedFrame* FrameEncoder::begin_frame() {
+    CapturedFrame* slot = queue.try_begin_push();
+    while (!slot) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        slot = queue.try_begin_push();
+    }
+    return slot;
+}
+
+void FrameEncoder::commit_frame() {
+    queue.commit_push();
+}
+
+void FrameEncoder::finish() {
+    stop_requested.store(true, std::memory_order_release);
+    if (encoder_thread.joinable()) {
+        encoder_thread.join();
+    }
+    if (raw_out.is_open()) {
+        raw_out.close();
+    }
+}
+
+int FrameEncoder::frames_written() const {
+    return written.load();
+}
+
+void FrameEncoder::encoder_loop() {
+    while (true) {
+        CapturedFrame* frame = queue.peek();
+        if (frame) {
+            write_frame(*frame);
+            queue.pop();
+            written++;
+            continue;
+        }
+        // Only exit once the queue is drained
+        if (stop_requested.load(std::memory_order_acquire) && !queue.peek()) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void FrameEncoder::write_frame(const CapturedFrame& frame) {
+    if (format == CaptureFormat::RAW_VIDEO) {
+        raw_out.write(reinterpret_cast<const char*>(frame.rgb.data()), static_cast<std::streamsize>(frame.rgb.size()));
+        return;
+    }
+
+    std::ostringstream name;
+    name << out_dir << "/frame_" << std::setw(6) << std::setfill('0') << frame.time_step << ".png";
+    if (!write_png_rgb(name.str(), frame.width, frame.height, frame.rgb)) {
+        std::cerr << "Capture: failed to write " << name.str() << std::endl;
+    }
+}
+
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t len) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static void write_chunk(std::ofstream& out, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    put_u32(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    uint32_t crc = crc32_update(0xFFFFFFFFu, chunk.data() + 4, chunk.size() - 4) ^ 0xFFFFFFFFu;
+    put_u32(chunk, crc);
+    out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+
+bool write_png_rgb(const std::string& path, int width, int height, const std::vector<uint8_t>& rgb) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+
+    const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.write(reinterpret_cast<const char*>(signature), 8);
+
+    std::vector<uint8_t> ihdr;
+    put_u32(ihdr, static_cast<uint32_t>(width));
+    put_u32(ihdr, static_cast<uint32_t>(height));
+    ihdr.push_back(8);  // bit depth
+    ihdr.push_back(2);  // colour type: RGB
+    ihdr.push_back(0);  // compression
+    ihdr.push_back(0);  // filter
+    ihdr.push_back(0);  // interlace
+    write_chunk(out, "IHDR", ihdr);
+
+    // Scanlines, each prefixed by filter type 0 (none)
+    size_t row_bytes = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> raw;
+    raw.reserve((row_bytes + 1) * height);
+    for (int y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb.begin() + y * row_bytes, rgb.begin() + (y + 1) * row_bytes);
+    }
+
+#ifdef CAPTURE_ZLIB
+    // Fastest level: frames are mostly flat background, so even that shrinks them a lot
+    uLongf compressed = compressBound(static_cast<uLong>(raw.size()));
+    std::vector<uint8_t> idat(compressed);
+    if (compress2(idat.data(), &compressed, raw.data(), static_cast<uLong>(raw.size()), Z_BEST_SPEED) != Z_OK) {
+        return false;
+    }
+    idat.resize(compressed);
+#else
+    // zlib stream made of stored deflate blocks
+    std::vector<uint8_t> idat = {0x78, 0x01};
+    uint32_t a = 1, b = 0;
+    size_t pos = 0;
+    do {
+        size_t len = std::min<size_t>(65535, raw.size() - pos);
+        bool last = pos + len == raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(static_cast<uint8_t>(len));
+        idat.push_back(static_cast<uint8_t>(len >> 8));
+        idat.push_back(static_cast<uint8_t>(~len));
+        idat.push_back(static_cast<uint8_t>(~len >> 8));
+        for (size_t i = pos; i < pos + len; i++) {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+    } while (pos < raw.size());
+    put_u32(idat, (b << 16) | a);
+#endif
+    write_chunk(out, "IDAT", idat);
+
+    write_chunk(out, "IEND", {});
+    return static_cast<bool>(out);
+}
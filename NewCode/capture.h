@@ -0,0 +1,58 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "snapshot.h"
+
+enum class CaptureFormat {
+    PNG_SEQUENCE = 0,   // one frame_<tick>.png per rendered frame (uncompressed unless CAPTURE_ZLIB, see write_png_rgb)
+    RAW_VIDEO = 1       // rgb24 stream in frames.rgb (ffmpeg -f rawvideo -pixel_format rgb24 ...)
+};
+
+class CapturedFrame {
+public:
+    int time_step = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> rgb;  // width * height * 3, row-major
+};
+
+// Writes rendered frames to disk on a background thread. The render thread fills
+// frames in place through begin_frame()/commit_frame(); the encoder drains them.
+class FrameEncoder {
+public:
+    FrameEncoder(const std::string& out_dir, CaptureFormat format);
+    ~FrameEncoder();
+
+    // Blocks the caller (the render thread, never the simulation) while the queue is full
+    CapturedFrame* begin_frame();
+    void commit_frame();
+    // Flush all queued frames and stop the encoder thread
+    void finish();
+
+    int frames_written() const;
+
+private:
+    std::string out_dir;
+    CaptureFormat format;
+    std::ofstream raw_out;
+    SnapshotRing<CapturedFrame, 8> queue;
+    std::thread encoder_thread;
+    std::atomic<bool> stop_requested;
+    std::atomic<int> written;
+
+    void encoder_loop();
+    void write_frame(const CapturedFrame& frame);
+};
+
+// Minimal PNG writer for lossless frame dumps. Build with -DCAPTURE_ZLIB (and link -lz) to
+// deflate the image data; without it the data is stored uncompressed, so every file is as
+// large as the raw RGB frame (width * height * 3 bytes).
+bool write_png_rgb(const std::string& path, int width, int height, const std::vector<uint8_t>& rgb);
+
+#endif //capture
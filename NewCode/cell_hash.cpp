@@ -0,0 +1,87 @@
+#include "cell_hash.h"
+
+#include <algorithm>
+#include <cmath>
+
+const int MIN_SLOTS = 64;
+const float MAX_CELL_COORD = 1073741824.0f;  // 2^30
+
+int CellHash::coord(float v, float cell_size) {
+    float c = std::floor(v / cell_size);
+    if (!(c > -MAX_CELL_COORD)) return -(1 << 30);  // also catches NaN
+    if (c > MAX_CELL_COORD) return 1 << 30;
+    return static_cast<int>(c);
+}
+
+uint64_t CellHash::key(int bx, int by) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(bx)) << 32) | static_cast<uint32_t>(by);
+}
+
+int CellHash::find_slot(uint64_t k) const {
+    int s = static_cast<int>((k * 0x9E3779B97F4A7C15ull) >> 40) & this->mask;
+    while (this->slots[s].base >= 0 && this->slots[s].key != k) {
+        s = (s + 1) & this->mask;
+    }
+    return s;
+}
+
+int CellHash::find_block(int bx, int by) const {
+    if (this->slots.empty()) return -1;
+    return this->slots[this->find_slot(key(bx, by))].base;
+}
+
+void CellHash::clear() {
+    if (this->slots.empty()) {
+        this->slots.assign(MIN_SLOTS, Slot{0, -1});
+        this->mask = MIN_SLOTS - 1;
+    }
+    for (Slot& s : this->slots) s.base = -1;
+    this->num_blocks = 0;
+    this->offsets.assign(1, 0);
+}
+
+void CellHash::grow() {
+    std::vector<Slot> old = std::move(this->slots);
+    this->slots.assign(old.size() * 2, Slot{0, -1});
+    this->mask = static_cast<int>(this->slots.size()) - 1;
+    for (const Slot& s : old) {
+        if (s.base >= 0) this->slots[this->find_slot(s.key)] = s;
+    }
+}
+
+int CellHash::add(int cx, int cy) {
+    int bx = floor_div(cx), by = floor_div(cy);
+    uint64_t k = key(bx, by);
+    int s = this->find_slot(k);
+    if (this->slots[s].base < 0) {
+        // Keep the load factor at most 1/2
+        if (2 * (this->num_blocks + 1) > static_cast<int>(this->slots.size())) {
+            this->grow();
+            s = this->find_slot(k);
+        }
+        this->slots[s] = {k, this->num_blocks * BLOCK * BLOCK};
+        this->num_blocks++;
+        this->offsets.resize(this->offsets.size() + BLOCK * BLOCK, 0);
+    }
+    int cell = this->slots[s].base + (cy - by * BLOCK) * BLOCK + (cx - bx * BLOCK);
+    this->offsets[cell + 1]++;
+    return cell;
+}
+
+int CellHash::finish() {
+    for (size_t c = 1; c < this->offsets.size(); c++) {
+        this->offsets[c] += this->offsets[c - 1];
+    }
+    this->cursor.assign(this->offsets.begin(), this->offsets.end() - 1);
+    return this->offsets.back();
+}
+
+void CellHash::range(int cx, int cy, int& begin, int& end) const {
+    begin = end = 0;
+    int bx = floor_div(cx), by = floor_div(cy);
+    int base = this->find_block(bx, by);
+    if (base < 0) return;
+    int cell = base + (cy - by * BLOCK) * BLOCK + (cx - bx * BLOCK);
+    begin = this->offsets[cell];
+    end = this->offsets[cell + 1];
+}
@@ -0,0 +1,72 @@
+#ifndef CELL_HASH_H
+#define CELL_HASH_H
+
+#include <cstdint>
+#include <vector>
+
+// Sparse table of square cells, each owning a contiguous range of an entry array (CSR).
+// Cells are grouped in BLOCK x BLOCK blocks that are allocated only where something is
+// added, found through an open-addressing hash of block coordinates. Memory follows the
+// occupied area rather than the area of a bounding box, and there is no origin or extent:
+// any float coordinate maps to a cell. Inside a block, cells are dense and row-major, so
+// the cells of one row of a block are a single entry range.
+//
+// Built in two passes over the same entries: add() each entry's cell, finish(), then place
+// each entry at next_slot() of the cell add() returned. Capacity is kept between builds.
+class CellHash {
+public:
+    static const int BLOCK = 8;
+
+    // Cell coordinate of v (clamped far outside any practical extent)
+    static int coord(float v, float cell_size);
+
+    void clear();
+    // Count one more entry for cell (cx, cy); returns the cell's id for next_slot()
+    int add(int cx, int cy);
+    // Turn the counts into offsets; returns the total number of entries
+    int finish();
+    // Entry position for the next entry of a cell (second pass, after finish)
+    int next_slot(int cell) { return this->cursor[cell]++; }
+
+    // Entry range [begin, end) of cell (cx, cy); empty if the cell holds nothing
+    void range(int cx, int cy, int& begin, int& end) const;
+
+    // Call visit(begin, end) for the entries of every cell in [cx0, cx1] x [cy0, cy1], one
+    // call per row of each block touched
+    template <class Visit>
+    void for_each_range(int cx0, int cx1, int cy0, int cy1, const Visit& visit) const {
+        for (int cy = cy0; cy <= cy1; cy++) {
+            int by = floor_div(cy), ly = cy - by * BLOCK;
+            for (int bx = floor_div(cx0); bx <= floor_div(cx1); bx++) {
+                int base = this->find_block(bx, by);
+                if (base < 0) continue;
+                int lx0 = cx0 > bx * BLOCK ? cx0 - bx * BLOCK : 0;
+                int lx1 = cx1 < bx * BLOCK + BLOCK - 1 ? cx1 - bx * BLOCK : BLOCK - 1;
+                int row = base + ly * BLOCK;
+                visit(this->offsets[row + lx0], this->offsets[row + lx1 + 1]);
+            }
+        }
+    }
+
+    int blocks() const { return this->num_blocks; }
+
+private:
+    struct Slot {
+        uint64_t key;
+        int base;     // first cell id of the block, -1 if the slot is free
+    };
+
+    std::vector<Slot> slots;
+    std::vector<int> offsets;     // per cell + 1: counts, then CSR offsets after finish()
+    std::vector<int> cursor;      // per cell: next free entry position
+    int num_blocks = 0;
+    int mask = -1;
+
+    static int floor_div(int c) { return c >= 0 ? c / BLOCK : -((-c + BLOCK - 1) / BLOCK); }
+    static uint64_t key(int bx, int by);
+    int find_slot(uint64_t k) const;
+    int find_block(int bx, int by) const;  // base cell id, -1 if absent
+    void grow();
+};
+
+#endif //cell_hash
@@ -0,0 +1,164 @@
+#include "checkpoint.h"
+#include "user.h"
+#include "alloc_tracking.h"
+#include "profiler.h"
+
+#include <atomic>
+#include <iostream>
+
+#include <algorithm>
+#include <climits>
+
+SimulationSnapshot Simulation::snapshot() const {
+    SimulationSnapshot snap;
+    snap.time_step = this->time_step;
+    snap.rng = this->rng;
+    snap.log_likelihood_ratio = this->log_likelihood_ratio;
+
+    snap.humans.reserve(this->human_agents.size());
+    for (const auto& [id, h] : this->human_agents) {
+        snap.humans.push_back(*h);
+    }
+
+    snap.animals.reserve(this->animal_agents.size());
+    for (const auto& a : this->animal_agents) {
+        snap.animals.push_back(*a);
+    }
+    snap.contact_events = this->contact_events;
+    return snap;
+}
+
+void Simulation::restore(const SimulationSnapshot& snap) {
+    this->time_step = snap.time_step;
+    this->rng = snap.rng;
+    this->log_likelihood_ratio = snap.log_likelihood_ratio;
+    this->contact_events = snap.contact_events;
+
+    // Resetting to the scenario a simulation last ran (the usual case between trials) copies
+    // every agent over its old self, so the agents' containers keep their capacity and nothing
+    // is allocated; any other population is rebuilt, through clear_agents so the dense index
+    // of the old humans is dropped with them
+    bool same_humans = this->human_agents.size() == snap.humans.size() &&
+        std::equal(snap.humans.begin(), snap.humans.end(), this->human_agents.begin(),
+                   [](const Human& h, const auto& kv) { return h.id == kv.first; });
+    bool same_animals = this->animal_agents.size() == snap.animals.size();
+    if (same_humans && same_animals) {
+        // Same ids, so the same dense indices, whether or not the snapshot was taken before indexing
+        auto it = this->human_agents.begin();
+        for (const Human& h : snap.humans) {
+            Human& target = *(it++)->second;
+            int index = target.index;
+            target = h;
+            target.index = index;
+        }
+        for (size_t i = 0; i < snap.animals.size(); i++) {
+            *this->animal_agents[i] = snap.animals[i];
+        }
+    } else {
+        this->clear_agents();
+        for (const AnimalPresence& a : snap.animals) {
+            this->add_agent(std::make_unique<AnimalPresence>(a));
+        }
+        for (const Human& h : snap.humans) {
+            this->add_agent(std::make_unique<Human>(h));
+        }
+    }
+}
+
+int deterministic_prefix_ticks(const Simulation& sim) {
+    // Infection draws happen every tick once spread is simulated
+    if (user::SIMULATE_SPREAD) {
+        return sim.time_step;
+    }
+
+    // Motion noise is drawn on any tick that is not a keyframe but has a keyframe after it
+    int prefix = INT_MAX;
+    for (const auto& [id, h] : sim.human_agents) {
+        if (h->location_history.empty()) continue;
+        int last_keyframe = h->location_history.rbegin()->first;
+        int t = sim.time_step;
+        while (t < last_keyframe && h->location_history.count(t)) {
+            t++;
+        }
+        if (t < last_keyframe) {
+            prefix = std::min(prefix, t);
+        }
+    }
+
+    // Stochastic animal models also draw on every tick an animal is not pinned to a keyframe
+    if (sim.engine.random_animal_motion) {
+        for (const auto& a : sim.animal_agents) {
+            int t = sim.time_step;
+            while (a->migration_pattern.count(t)) {
+                t++;
+            }
+            prefix = std::min(prefix, t);
+        }
+    }
+
+    int end = seconds_to_sim_ticks(STOP_SIM_AFTER);
+    return std::min(prefix, end);
+}
+
+std::unique_ptr<Simulation> SimulationCache::acquire() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    if (this->idle.empty()) return nullptr;
+    std::unique_ptr<Simulation> sim = std::move(this->idle.back());
+    this->idle.pop_back();
+    return sim;
+}
+
+void SimulationCache::release(std::unique_ptr<Simulation> sim) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->idle.push_back(std::move(sim));
+}
+
+std::vector<TrialResult> fork_trials(const SimulationSnapshot& snap, int first, int count,
+                                     uint64_t run_seed, bool antithetic_pairs,
+                                     WorkStealingPool* pool, SimulationCache* cache) {
+    std::vector<TrialResult> results(count);
+    SimulationCache private_cache;
+    if (!cache) cache = &private_cache;
+    std::atomic<long> reused_trials(0);
+    std::atomic<long> allocating_trials(0);
+    std::atomic<long> allocated_blocks(0);
+
+    auto run_child = [&](int k) {
+        PhaseTimer timer(Phase::TRIAL);
+        std::unique_ptr<Simulation> child = cache->acquire();
+        bool reused = child != nullptr;
+        if (!reused) child = std::make_unique<Simulation>();
+
+        AllocationScope scope;
+        child->restore(snap);
+        child->rng = trial_random(run_seed, first + k, antithetic_pairs);
+        run_to_end(*child);
+        long allocations = scope.allocations();
+
+        results[k] = child->get_results();
+        // A reset simulation should run the whole trial without touching the heap once its
+        // buffers have grown to the scenario (counts are per thread, so this only holds when
+        // the child's ticks ran on this thread)
+        if (reused && child->tick_pool == nullptr) {
+            reused_trials++;
+            if (allocations > 0) {
+                allocating_trials++;
+                allocated_blocks += allocations;
+            }
+        }
+        cache->release(std::move(child));
+    };
+
+    if (pool) {
+        pool->run(count, run_child);
+    } else {
+        for (int k = 0; k < count; ++k) run_child(k);
+    }
+#ifdef TRACK_ALLOCATIONS
+    if (allocating_trials != 0) {
+        std::cerr << "Steady state: " << allocating_trials << " of " << reused_trials
+                  << " reset trials allocated (" << allocated_blocks << " heap blocks)" << std::endl;
+    }
+#endif
+    return results;
+}
@@ -0,0 +1,50 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "agents.h"
+#include "simulator.h"
+#include "scheduler.h"
+
+// Complete, self-contained copy of a Simulation at the start of a tick: agents with their
+// contact maps, sickness records and infection models, the tick counter, and the RNG
+// (whose whole state is its seed, see random.h).
+struct SimulationSnapshot {
+    int time_step = 0;
+    SimRandom rng;
+    double log_likelihood_ratio = 0.0;
+    std::vector<Human> humans;
+    std::vector<AnimalPresence> animals;
+    std::vector<ContactEvent> contact_events;
+};
+
+// Number of leading ticks in which no agent draws a random number. Every trial of the
+// scenario is identical over this prefix regardless of seed.
+int deterministic_prefix_ticks(const Simulation& sim);
+
+// Idle simulations kept between trials, so each trial resets one in place (see restore)
+// instead of building and tearing down every agent. Holds at most as many simulations as
+// trials ever ran at once. Thread-safe.
+class SimulationCache {
+public:
+    // An idle simulation, or nullptr if there is none
+    std::unique_ptr<Simulation> acquire();
+    void release(std::unique_ptr<Simulation> sim);
+
+private:
+    std::mutex lock;
+    std::vector<std::unique_ptr<Simulation>> idle;
+};
+
+// Run trials [first, first + count) to the end from one snapshot; trial i is reseeded with
+// trial_random(run_seed, i, ...). With a pool the trials run in parallel; results stay in trial order.
+// Simulations are taken from and returned to cache (a private one if nullptr).
+std::vector<TrialResult> fork_trials(const SimulationSnapshot& snap, int first, int count,
+                                     uint64_t run_seed, bool antithetic_pairs,
+                                     WorkStealingPool* pool = nullptr, SimulationCache* cache = nullptr);
+
+#endif //checkpoint
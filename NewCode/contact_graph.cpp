@@ -0,0 +1,130 @@
+#include "contact_graph.h"
+#include "agents.h"
+#include "simulator.h"
+
+#include <algorithm>
+#include <numeric>
+
+ContactGraph build_contact_graph(const Simulation& sim) {
+    ContactGraph g;
+    int n = static_cast<int>(sim.human_agents.size());
+    g.ids.reserve(n);
+    g.onset_offsets.assign(n + 1, 0);
+
+    // Vertices are the simulation's dense indices, which follow the map's id order
+    for (const auto& [id, h] : sim.human_agents) {
+        int v = static_cast<int>(g.ids.size());
+        g.ids.push_back(id);
+        for (const auto& s : h->sickness_records) {
+            g.onsets.push_back(s.start_time);
+        }
+        g.onset_offsets[v + 1] = static_cast<int>(g.onsets.size());
+    }
+
+    // Closed contacts from the stream, plus contacts still open when the trial ended
+    std::vector<std::pair<int, ContactEdge>> rows;
+    rows.reserve(sim.contact_events.size());
+    for (const ContactEvent& e : sim.contact_events) {
+        rows.push_back({e.source, {e.target, e.start_time, e.end_time, e.target_status}});
+    }
+    for (const auto& [id, h] : sim.human_agents) {
+        for (const auto& [other, c] : h->active_contacts) {
+            rows.push_back({h->index, {other, c.start_time, sim.time_step, c.other_status}});
+        }
+    }
+
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        if (a.first != b.first) return a.first < b.first;
+        if (a.second.target != b.second.target) return a.second.target < b.second.target;
+        return a.second.start_time < b.second.start_time;
+    });
+
+    g.row_offsets.assign(n + 1, 0);
+    g.edges.reserve(rows.size());
+    for (const auto& [s, edge] : rows) {
+        g.row_offsets[s + 1]++;
+        g.edges.push_back(edge);
+    }
+    std::partial_sum(g.row_offsets.begin(), g.row_offsets.end(), g.row_offsets.begin());
+    return g;
+}
+
+std::vector<int> contact_degrees(const ContactGraph& g) {
+    std::vector<int> degrees(g.num_vertices(), 0);
+    for (int v = 0; v < g.num_vertices(); v++) {
+        int prev = -1;
+        for (int k = g.row_offsets[v]; k < g.row_offsets[v + 1]; k++) {
+            if (g.edges[k].target != prev) degrees[v]++;
+            prev = g.edges[k].target;
+        }
+    }
+    return degrees;
+}
+
+std::vector<TransmissionLink> transmission_chains(const ContactGraph& g) {
+    std::vector<TransmissionLink> links;
+    links.reserve(g.onsets.size());
+    for (int v = 0; v < g.num_vertices(); v++) {
+        for (int k = g.onset_offsets[v]; k < g.onset_offsets[v + 1]; k++) {
+            links.push_back({v, g.onsets[k], -1, 0});
+        }
+    }
+    // Infectors have strictly earlier onsets, so their generations are known by the time they are needed
+    std::sort(links.begin(), links.end(), [](const auto& a, const auto& b) {
+        return a.onset != b.onset ? a.onset < b.onset : a.vertex < b.vertex;
+    });
+
+    // Index of each link by (vertex, onset position), to look up an infector's generation
+    std::vector<int> link_of(g.onsets.size());
+    for (int i = 0; i < static_cast<int>(links.size()); i++) {
+        const TransmissionLink& l = links[i];
+        int k = g.onset_offsets[l.vertex];
+        while (g.onsets[k] != l.onset) k++;
+        link_of[k] = i;
+    }
+
+    for (TransmissionLink& l : links) {
+        int latest_start = -1;
+        for (int k = g.row_offsets[l.vertex]; k < g.row_offsets[l.vertex + 1]; k++) {
+            const ContactEdge& e = g.edges[k];
+            if (e.target_status != HumanStatus::SICK) continue;
+            if (e.start_time > l.onset || e.start_time < l.onset - INCUBATION_SIM_TIME) continue;
+            if (e.start_time <= latest_start) continue;
+
+            // The infector's sickness that was running when the contact started, begun before this onset
+            int infector_onset = -1;
+            for (int j = g.onset_offsets[e.target]; j < g.onset_offsets[e.target + 1]
+                 && g.onsets[j] <= e.start_time && g.onsets[j] < l.onset; j++) {
+                infector_onset = j;
+            }
+            if (infector_onset < 0) continue;
+
+            latest_start = e.start_time;
+            l.infector = e.target;
+            l.generation = links[link_of[infector_onset]].generation + 1;
+        }
+    }
+    return links;
+}
+
+ContactGraphSummary summarize_contact_graph(const ContactGraph& g) {
+    ContactGraphSummary s;
+    s.recorded = true;
+    s.edges = static_cast<int>(g.edges.size());
+
+    std::vector<int> degrees = contact_degrees(g);
+    for (int d : degrees) {
+        s.mean_degree += d;
+        s.max_degree = std::max(s.max_degree, d);
+    }
+    if (!degrees.empty()) s.mean_degree /= degrees.size();
+
+    std::vector<TransmissionLink> links = transmission_chains(g);
+    for (const TransmissionLink& l : links) {
+        if (l.infector < 0) s.chains++;
+        s.longest_chain = std::max(s.longest_chain, l.generation + 1);
+    }
+    // Every non-root link is one infection attributed to some onset
+    if (!links.empty()) s.mean_attributed_infections = static_cast<double>(links.size() - s.chains) / links.size();
+    return s;
+}
@@ -0,0 +1,72 @@
+#ifndef CONTACT_GRAPH_H
+#define CONTACT_GRAPH_H
+
+#include <vector>
+
+enum class HumanStatus;
+class Simulation;
+
+// One closed (or, at the end of a trial, still open) human-human contact as seen by source.
+// Humans are dense indices (see Simulation::human_order).
+struct ContactEvent {
+    int source;
+    int target;
+    int start_time;
+    int end_time;
+    HumanStatus target_status;  // target's status when the contact started
+};
+
+struct ContactEdge {
+    int target;                 // dense vertex index
+    int start_time;
+    int end_time;
+    HumanStatus target_status;
+};
+
+// Whole-trial contact graph in compressed sparse row form. Vertices are humans in id order
+// (dense indices, ids[v] maps back); the edges of v are [row_offsets[v], row_offsets[v + 1])
+// sorted by (target, start_time). Sickness onsets are stored the same way. Built once from
+// the contact event stream after a trial; every analysis is a linear scan over these arrays.
+struct ContactGraph {
+    std::vector<int> ids;
+    std::vector<int> row_offsets;
+    std::vector<ContactEdge> edges;
+    std::vector<int> onset_offsets;
+    std::vector<int> onsets;    // ascending per vertex
+
+    int num_vertices() const { return static_cast<int>(this->ids.size()); }
+};
+
+// Which sickness infected which: the infector of an onset is the most recent contact that was
+// sick when the contact started, started within INCUBATION_SIM_TIME before the onset, and whose
+// sickness began before it
+struct TransmissionLink {
+    int vertex;
+    int onset;
+    int infector;      // vertex, or -1 for a chain root (no human source: zoonotic or seeded)
+    int generation;    // 0 for roots
+};
+
+// Per-trial analytics carried in TrialResult (recorded = false unless contacts were recorded)
+struct ContactGraphSummary {
+    bool recorded = false;
+    int edges = 0;
+    double mean_degree = 0.0;   // distinct contacts per human
+    int max_degree = 0;
+    int chains = 0;             // transmission chain roots
+    int longest_chain = 0;      // generations in the deepest chain
+    double mean_attributed_infections = 0.0;  // infections attributed to an onset, averaged over onsets
+};
+
+ContactGraph build_contact_graph(const Simulation& sim);
+
+// Distinct contacts per vertex
+std::vector<int> contact_degrees(const ContactGraph& graph);
+// One link per sickness onset, in (onset, vertex) order. An infector's onset is always strictly
+// earlier than the onsets it is linked to, so same-tick onsets never infect each other.
+// Attributed infections (links per infector) are not the per-human secondary cases, which
+// Human::secondary_cases defines during the run for the zoonotic probability.
+std::vector<TransmissionLink> transmission_chains(const ContactGraph& graph);
+ContactGraphSummary summarize_contact_graph(const ContactGraph& graph);
+
+#endif //contact_graph
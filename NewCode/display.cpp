@@ -1,28 +1,63 @@
 #include "display.h"
 #include "agents.h"
 #include "simulator.h"
+#include "profiler.h"
 #include <SDL.h>
 #include <SDL_ttf.h>
 #include <iostream>
 #include <string>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <algorithm>
 
 const int FRAMES_PER_SECOND = 10;
 
-Display::Display(Simulation* sim, int width, int height)
-    : simulation(sim), width(width), height(height) {
+// First readable font wins; ZVSIM_FONT overrides. Without a font, labels are skipped.
+static const char* FONT_PATHS[] = {
+    "/System/Library/Fonts/Helvetica.ttc",
+    "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+    "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+    "/usr/share/fonts/TTF/DejaVuSans.ttf",
+    "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
+};
+
+Display::Display(Simulation* sim, int width, int height, const WorldView& view,
+                 const std::string& capture_dir, CaptureFormat capture_format)
+    : simulation(sim), width(width), height(height), view(view),
+      scale(std::min(width / (view.max_x - view.min_x), height / (view.max_y - view.min_y))),
+      encoder(nullptr), capture_dir(capture_dir), capture_format(capture_format),
+      open(true), stop_requested(false), dropped_frames(0) {
     initialized = false;
+    headless = !capture_dir.empty();
     window = nullptr;
     renderer = nullptr;
+    framebuffer = nullptr;
     font = nullptr;
-    
+    bgColor = {255, 255, 255, 255};
+
+    // Video and event calls are only safe on the main thread, so the window is opened here and
+    // rendered from run(). Headless mode uses no video subsystem: its software renderer lives
+    // on the capture thread. Either way the simulation only touches the lock-free buffers.
+    if (!(headless ? init_headless() : init())) {
+        open = false;
+        shutdown();
+        return;
+    }
+    if (headless) {
+        capture_thread = std::thread(&Display::capture_loop, this);
+    }
+}
+
+bool Display::init() {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         std::cerr << "SDL Init Error: " << SDL_GetError() << std::endl;
-        return;
+        return false;
     }
     
     if (TTF_Init() < 0) {
         std::cerr << "TTF Init Error: " << TTF_GetError() << std::endl;
-        return;
+        return false;
     }
     
     window = SDL_CreateWindow("Agent Movement Simulation",
@@ -32,28 +67,117 @@ Display::Display(Simulation* sim, int width, int height)
                               SDL_WINDOW_SHOWN);
     if (!window) {
         std::cerr << "SDL_CreateWindow Error: " << SDL_GetError() << std::endl;
-        return;
+        return false;
     }
     
     renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
     if (!renderer) {
         std::cerr << "SDL_CreateRenderer Error: " << SDL_GetError() << std::endl;
-        return;
+        return false;
     }
     
-    font = TTF_OpenFont("/System/Library/Fonts/Helvetica.ttc", 15);
-    if (!font) {
-        std::cerr << "Font loading failed: " << TTF_GetError() << std::endl;
+    open_font();
+    initialized = true;
+    return true;
+}
+
+bool Display::init_headless() {
+    // No video subsystem needed: the software renderer draws straight into a surface
+    if (TTF_Init() < 0) {
+        std::cerr << "TTF Init Error: " << TTF_GetError() << std::endl;
     }
-    
-    bgColor = {255, 255, 255, 255};
+
+    framebuffer = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!framebuffer) {
+        std::cerr << "SDL_CreateRGBSurfaceWithFormat Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    renderer = SDL_CreateSoftwareRenderer(framebuffer);
+    if (!renderer) {
+        std::cerr << "SDL_CreateSoftwareRenderer Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    open_font();
+    encoder = new FrameEncoder(capture_dir, capture_format);
     initialized = true;
+    return true;
+}
+
+void Display::open_font() {
+    const char* override_path = std::getenv("ZVSIM_FONT");
+    if (override_path) {
+        font = TTF_OpenFont(override_path, 15);
+    }
+    for (const char* path : FONT_PATHS) {
+        if (font) break;
+        if (std::ifstream(path).good()) {
+            font = TTF_OpenFont(path, 15);
+        }
+    }
+    if (!font) {
+        std::cerr << "Font loading failed, labels disabled: " << TTF_GetError() << std::endl;
+    }
 }
 
 Display::~Display() {
     cleanup();
 }
 
+void Display::publish() {
+    if (headless) {
+        // Every tick is recorded; if the encoder falls behind the frame is dropped
+        // rather than stalling the simulation
+        FrameSnapshot* slot = capture_queue.try_begin_push();
+        if (!slot) {
+            dropped_frames++;
+            return;
+        }
+        slot->capture(*simulation);
+        capture_queue.commit_push();
+        return;
+    }
+    snapshots.write_slot().capture(*simulation);
+    snapshots.publish();
+}
+
+bool Display::is_open() const {
+    return open.load(std::memory_order_relaxed);
+}
+
+void Display::run(const std::function<void()>& simulation_loop) {
+    if (headless || !initialized) {
+        simulation_loop();
+        return;
+    }
+
+    // The loop stops on its own once the window closes (is_open() turns false)
+    std::thread simulation_thread([this, &simulation_loop] {
+        simulation_loop();
+        stop_requested.store(true, std::memory_order_release);
+    });
+    render_loop();
+    simulation_thread.join();
+}
+
+void Display::render_loop() {
+    const auto frame_time = std::chrono::milliseconds(1000 / FRAMES_PER_SECOND);
+    while (!stop_requested.load(std::memory_order_acquire)) {
+        auto frame_start = std::chrono::steady_clock::now();
+        if (!render()) {
+            open = false;
+            break;
+        }
+        std::this_thread::sleep_until(frame_start + frame_time);
+    }
+
+    // Show whatever the simulation published last; cleanup() tears the window down
+    if (open && snapshots.acquire()) {
+        render();
+    }
+}
+
 void Display::drawText(const std::string& text, int x, int y, SDL_Color color) {
     if (!font || !renderer) return;
     
@@ -77,23 +201,30 @@ bool Display::render() {
     if (!initialized || !window || !renderer) {
         return false;
     }
-for (const auto& [id, h] : simulation->human_agents) {
-    std::cout << "  Human " << id << " at (" << h->location.x << ", " << h->location.y << ")" << std::endl;
-}
+
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         if (event.type == SDL_QUIT) {
             return false;
         }
     }
+
+    snapshots.acquire();
+    draw(snapshots.read_slot());
+    SDL_RenderPresent(renderer);
     
+    return true;
+}
+
+void Display::draw(const FrameSnapshot& frame) {
+    PhaseTimer timer(Phase::DISPLAY);
     SDL_SetRenderDrawColor(renderer, bgColor.r, bgColor.g, bgColor.b, bgColor.a);
     SDL_RenderClear(renderer);
 
-    for (auto* agent : simulation->animal_agents) {
-        int x = static_cast<int>(agent->location.x);
-        int y = static_cast<int>(agent->location.y);
-        int radius = static_cast<int>(agent->radius);
+    for (const auto& agent : frame.animals) {
+        int x = static_cast<int>((agent.x - view.min_x) * scale);
+        int y = static_cast<int>((agent.y - view.min_y) * scale);
+        int radius = static_cast<int>(agent.radius * scale);
         
         SDL_SetRenderDrawColor(renderer, 0, 200, 0, 255);
         
@@ -108,17 +239,17 @@ for (const auto& [id, h] : simulation->human_agents) {
         }
         
         SDL_Color green = {0, 200, 0, 255};
-        std::string label = "A" + std::to_string(agent->id);
+        std::string label = "A" + std::to_string(agent.id);
         drawText(label, x, y - (radius + 10), green);
     }
     
-    for (const auto& [id, agent] : simulation->human_agents) {
-        int x = static_cast<int>(agent->location.x);
-        int y = static_cast<int>(agent->location.y);
-        int radius = 5;
+    for (const auto& agent : frame.humans) {
+        int x = static_cast<int>((agent.x - view.min_x) * scale);
+        int y = static_cast<int>((agent.y - view.min_y) * scale);
+        int radius = static_cast<int>(agent.radius * scale);
         
         SDL_Color color;
-        if (agent->status == HumanStatus::SICK) {
+        if (agent.status == HumanStatus::SICK) {
             color = {255, 0, 0, 255};
             SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
         } else {
@@ -137,30 +268,79 @@ for (const auto& [id, h] : simulation->human_agents) {
         }
         
 
-        std::string label = "H" + std::to_string(agent->id);
+        std::string label = "H" + std::to_string(agent.id);
         drawText(label, x, y - (radius + 10), color);
     }
     
 
     SDL_Color black = {0, 0, 0, 255};
-    std::string simTime = "Sim time: t=" + std::to_string(simulation->time_step);
+    std::string simTime = "Sim time: t=" + std::to_string(frame.time_step);
     drawText(simTime, 10, 10, black);
     
-    std::string realTime = "Real time: t=" + std::to_string(static_cast<int>(simulation->get_current_real_time())) + "s";
+    std::string realTime = "Real time: t=" + std::to_string(static_cast<int>(frame.real_time)) + "s";
     drawText(realTime, 10, 25, black);
-    
-    SDL_RenderPresent(renderer);
-    
+}
 
-    SDL_Delay(1000 / FRAMES_PER_SECOND);
-    
-    return true;
+void Display::capture_loop() {
+    while (true) {
+        FrameSnapshot* frame = capture_queue.peek();
+        if (frame) {
+            draw(*frame);
+            capture_frame(frame->time_step);
+            capture_queue.pop();
+            continue;
+        }
+        if (stop_requested.load(std::memory_order_acquire) && !capture_queue.peek()) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    encoder->finish();
+    if (dropped_frames > 0) {
+        std::cerr << "Capture: dropped " << dropped_frames << " frames (encoder too slow)" << std::endl;
+    }
+    shutdown();
+}
+
+void Display::capture_frame(int time_step) {
+    CapturedFrame* out = encoder->begin_frame();
+    out->time_step = time_step;
+    out->width = width;
+    out->height = height;
+    out->rgb.resize(static_cast<size_t>(width) * height * 3);
+
+    SDL_LockSurface(framebuffer);
+    const uint8_t* pixels = static_cast<const uint8_t*>(framebuffer->pixels);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = pixels + y * framebuffer->pitch;
+        uint8_t* dst = out->rgb.data() + static_cast<size_t>(y) * width * 3;
+        for (int x = 0; x < width; x++) {
+            dst[x * 3 + 0] = row[x * 4 + 0];
+            dst[x * 3 + 1] = row[x * 4 + 1];
+            dst[x * 3 + 2] = row[x * 4 + 2];
+        }
+    }
+    SDL_UnlockSurface(framebuffer);
+
+    encoder->commit_frame();
 }
 
 void Display::cleanup() {
+    stop_requested.store(true, std::memory_order_release);
+    if (capture_thread.joinable()) {
+        capture_thread.join();
+    } else if (initialized) {
+        shutdown();
+    }
+}
+
+void Display::shutdown() {
     if (font) { TTF_CloseFont(font); font = nullptr; }
     if (renderer) { SDL_DestroyRenderer(renderer); renderer = nullptr; }
     if (window) { SDL_DestroyWindow(window); window = nullptr; }
+    if (framebuffer) { SDL_FreeSurface(framebuffer); framebuffer = nullptr; }
+    if (encoder) { delete encoder; encoder = nullptr; }
     TTF_Quit();
     SDL_Quit();
     initialized = false;
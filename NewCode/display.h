@@ -1,8 +1,13 @@
 #pragma once
 #include <SDL.h>
 #include <string>
+#include <atomic>
+#include <functional>
+#include <thread>
 #include <SDL_ttf.h>
 #include "simulator.h"
+#include "snapshot.h"
+#include "capture.h"
 
 
 class Display {
@@ -10,17 +15,57 @@ class Display {
     Simulation* simulation;
     int width;
     int height;
+    WorldView view;
+    float scale;  // pixels per model unit
     SDL_Window* window;
     SDL_Renderer* renderer;
     SDL_Color bgColor;
     TTF_Font* font;
     bool initialized;
+    bool headless;
+    SDL_Surface* framebuffer;
 
 
-    Display(Simulation* sim, int width, int height);
+    // A non-empty capture_dir selects headless mode: no window, a software renderer
+    // draws into an in-memory framebuffer and every published tick is encoded to disk.
+    // view is scaled uniformly to fit the width x height pixels. Must be constructed on
+    // the main thread: the window is opened here, and is_open() is false on return if
+    // that (or the headless framebuffer) failed.
+    Display(Simulation* sim, int width, int height, const WorldView& view,
+            const std::string& capture_dir = "", CaptureFormat capture_format = CaptureFormat::PNG_SEQUENCE);
     ~Display();
 
+    // Run simulation_loop to completion. With a window, the loop runs on a worker thread
+    // while the calling (main) thread owns SDL and renders until the loop returns; headless,
+    // it runs on the calling thread while frames are encoded in the background.
+    void run(const std::function<void()>& simulation_loop);
+
+    // Simulation side: copy the current state into the snapshot buffer (never blocks)
+    void publish();
+    // False once the viewer window has been closed (or failed to open)
+    bool is_open() const;
+
     bool render();
+    void draw(const FrameSnapshot& frame);
     void cleanup();
     void drawText(const std::string& text, int x, int y, SDL_Color color);
-};
\ No newline at end of file
+
+    private:
+    SnapshotBuffer<FrameSnapshot> snapshots;
+    SnapshotRing<FrameSnapshot, 64> capture_queue;
+    FrameEncoder* encoder;
+    std::string capture_dir;
+    CaptureFormat capture_format;
+    std::thread capture_thread;
+    std::atomic<bool> open;
+    std::atomic<bool> stop_requested;
+    std::atomic<int> dropped_frames;
+
+    bool init();
+    bool init_headless();
+    void open_font();
+    void shutdown();
+    void render_loop();
+    void capture_loop();
+    void capture_frame(int time_step);
+};
@@ -0,0 +1,226 @@
+#include "domain.h"
+#include "agents.h"
+#include "simulator.h"
+#include "parallel.h"
+#include "cell_hash.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Slack added to every halo test, so float rounding in the exact distance tests can never
+// involve a human or animal the tile did not pull in
+static inline float halo_pad(float x, float y, float width) {
+    return 0.01f + 1e-5f * (std::fabs(x) + std::fabs(y) + width);
+}
+
+// Same test as HazardField and AnimalBVH, so tiled runs give bit-identical hazards
+static inline bool in_circle(float x, float y, const AnimalPresence& a) {
+    float dx = x - a.location.x;
+    float dy = y - a.location.y;
+    return std::sqrt(dx * dx + dy * dy) <= a.radius;
+}
+
+static inline bool near_bounds(const DomainTile& t, float x, float y, float reach) {
+    return x >= t.x0 - reach && x < t.x1 + reach && y >= t.y0 - reach && y < t.y1 + reach;
+}
+
+void DomainTile::animal_contacts(float x, float y, const std::vector<std::unique_ptr<AnimalPresence>>& all,
+                                 std::vector<int>& out) const {
+    for (int k : this->animals) {
+        if (in_circle(x, y, *all[k])) {
+            out.push_back(k);
+        }
+    }
+}
+
+static inline uint64_t tile_key(int tx, int ty) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(tx)) << 32) | static_cast<uint32_t>(ty);
+}
+
+DomainDecomposition::DomainDecomposition(float tile_size)
+    : tile_size(tile_size) {}
+
+int DomainDecomposition::tile_coord(float v) const {
+    return CellHash::coord(v, this->tile_size);
+}
+
+int DomainDecomposition::find_tile(int tx, int ty) const {
+    auto it = this->tile_index.find(tile_key(tx, ty));
+    return it == this->tile_index.end() ? -1 : it->second;
+}
+
+int DomainDecomposition::tile_at(float x, float y) {
+    int tx = this->tile_coord(x), ty = this->tile_coord(y);
+    uint64_t key = tile_key(tx, ty);
+    auto it = this->tile_index.find(key);
+    if (it != this->tile_index.end()) return it->second;
+
+    // New tiles take the buffers of a dropped one, so tiles coming and going don't allocate
+    if (this->spare_tiles.empty()) {
+        this->tiles.emplace_back();
+    } else {
+        this->tiles.push_back(std::move(this->spare_tiles.back()));
+        this->spare_tiles.pop_back();
+    }
+    DomainTile& t = this->tiles.back();
+    t.tx = tx;
+    t.ty = ty;
+    t.x0 = tx * this->tile_size;
+    t.x1 = t.x0 + this->tile_size;
+    t.y0 = ty * this->tile_size;
+    t.y1 = t.y0 + this->tile_size;
+    int index = static_cast<int>(this->tiles.size()) - 1;
+    this->tile_index[key] = index;
+    return index;
+}
+
+void DomainDecomposition::drop_empty_tiles() {
+    size_t kept = 0;
+    for (size_t t = 0; t < this->tiles.size(); t++) {
+        DomainTile& tile = this->tiles[t];
+        uint64_t key = tile_key(tile.tx, tile.ty);
+        if (tile.owned.empty()) {
+            this->tile_index.erase(this->tile_index.find(key));
+            this->spare_tiles.push_back(std::move(tile));
+            continue;
+        }
+        if (kept != t) {
+            this->tiles[kept] = std::move(tile);
+            this->tile_index[key] = static_cast<int>(kept);
+        }
+        kept++;
+    }
+    this->tiles.resize(kept);
+}
+
+void DomainDecomposition::assign_all(const Simulation& sim) {
+    for (DomainTile& tile : this->tiles) {
+        tile.owned.clear();
+        this->spare_tiles.push_back(std::move(tile));
+    }
+    this->tiles.clear();
+    this->tile_index.clear();
+    for (size_t i = 0; i < sim.human_front.size(); i++) {
+        const HumanTickState& s = sim.human_front[i];
+        this->tiles[this->tile_at(s.x, s.y)].owned.push_back(static_cast<int>(i));
+    }
+    this->assigned_order.assign(sim.human_order.begin(), sim.human_order.end());
+}
+
+void DomainDecomposition::migrate(const Simulation& sim) {
+    // Each tile keeps the humans still inside it and sends the others out
+    parallel_ranges(sim.tick_pool, this->tiles.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            DomainTile& tile = this->tiles[t];
+            tile.outbox.clear();
+            size_t kept = 0;
+            for (int i : tile.owned) {
+                const HumanTickState& s = sim.human_front[i];
+                if (this->tile_coord(s.x) == tile.tx && this->tile_coord(s.y) == tile.ty) {
+                    tile.owned[kept++] = i;
+                } else {
+                    tile.outbox.push_back(i);
+                }
+            }
+            tile.owned.resize(kept);
+        }
+    });
+
+    // Route the leavers (creating tiles they move into) in tile order...
+    size_t sending = this->tiles.size();
+    for (size_t t = 0; t < sending; t++) {
+        for (size_t k = 0; k < this->tiles[t].outbox.size(); k++) {
+            int i = this->tiles[t].outbox[k];
+            const HumanTickState& s = sim.human_front[i];
+            this->tiles[this->tile_at(s.x, s.y)].inbox.push_back(i);
+            this->migrations++;
+        }
+    }
+
+    // ...and let each tile take in its arrivals
+    parallel_ranges(sim.tick_pool, this->tiles.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            DomainTile& tile = this->tiles[t];
+            if (tile.inbox.empty()) continue;
+            tile.owned.insert(tile.owned.end(), tile.inbox.begin(), tile.inbox.end());
+            std::sort(tile.owned.begin(), tile.owned.end());
+            tile.inbox.clear();
+        }
+    });
+}
+
+void DomainDecomposition::build_halo(const Simulation& sim, DomainTile& tile) const {
+    // Tiles beyond this many steps are too far for any of their humans to be within the halo width
+    int reach = static_cast<int>(std::floor(this->halo_width / this->tile_size * 1.001f + 0.001f)) + 1;
+
+    tile.halo.clear();
+    for (int sy = tile.ty - reach; sy <= tile.ty + reach; sy++) {
+        for (int sx = tile.tx - reach; sx <= tile.tx + reach; sx++) {
+            int source = (sx == tile.tx && sy == tile.ty) ? -1 : this->find_tile(sx, sy);
+            if (source < 0) continue;
+            for (int i : this->tiles[source].owned) {
+                const HumanTickState& s = sim.human_front[i];
+                if (near_bounds(tile, s.x, s.y, this->halo_width + halo_pad(s.x, s.y, this->halo_width))) {
+                    tile.halo.push_back(i);
+                }
+            }
+        }
+    }
+    std::sort(tile.halo.begin(), tile.halo.end());
+
+    // Owned and halo humans in id order (human_order indices are in id order)
+    tile.local.clear();
+    size_t a = 0, b = 0;
+    while (a < tile.owned.size() || b < tile.halo.size()) {
+        bool take_owned = b == tile.halo.size() || (a < tile.owned.size() && tile.owned[a] < tile.halo[b]);
+        tile.local.push_back(sim.human_front[take_owned ? tile.owned[a++] : tile.halo[b++]]);
+    }
+    tile.grid.build(tile.local, CONTACT_NETWORK_PROXIMITY_THRESHOLD);
+
+}
+
+void DomainDecomposition::bucket_animals(const Simulation& sim) {
+    // Animals are not owned by tiles; each hazardous one is listed by the tiles it reaches
+    // into, found through the tile index around it (one pass over the animals per tick, in
+    // index order, so every list is ascending)
+    for (DomainTile& tile : this->tiles) tile.animals.clear();
+    for (size_t k = 0; k < sim.animal_agents.size(); k++) {
+        const AnimalPresence& an = *sim.animal_agents[k];
+        if (an.infection_model.output_hazard == 0.0f) continue;
+        float x = an.location.x, y = an.location.y;
+        float reach = an.radius + halo_pad(x, y, an.radius);
+        // One tile of slack on each side; near_bounds decides
+        int tx0 = this->tile_coord(x - reach) - 1, tx1 = this->tile_coord(x + reach) + 1;
+        int ty0 = this->tile_coord(y - reach) - 1, ty1 = this->tile_coord(y + reach) + 1;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                int t = this->find_tile(tx, ty);
+                if (t >= 0 && near_bounds(this->tiles[t], x, y, reach)) {
+                    this->tiles[t].animals.push_back(static_cast<int>(k));
+                }
+            }
+        }
+    }
+}
+
+void DomainDecomposition::exchange(const Simulation& sim) {
+    this->halo_width = CONTACT_NETWORK_PROXIMITY_THRESHOLD;
+    for (const auto& a : sim.animal_agents) {
+        this->halo_width = std::max(this->halo_width, a->radius);
+    }
+
+    if (!std::equal(sim.human_order.begin(), sim.human_order.end(),
+                    this->assigned_order.begin(), this->assigned_order.end())) {
+        this->assign_all(sim);
+    } else {
+        this->migrate(sim);
+        this->drop_empty_tiles();
+    }
+
+    this->bucket_animals(sim);
+    parallel_ranges(sim.tick_pool, this->tiles.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            this->build_halo(sim, this->tiles[t]);
+        }
+    });
+}
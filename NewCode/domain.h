@@ -0,0 +1,72 @@
+#ifndef DOMAIN_H
+#define DOMAIN_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "human_grid.h"
+#include "flat_map.h"
+
+class AnimalPresence;
+class Human;
+class Simulation;
+struct HumanTickState;
+
+// One tile of a domain-decomposed world. The tile owns the humans inside its bounds and
+// updates only them, seeing the rest of the world through its halo: the humans owned by
+// other tiles, and the animals, that lie within the halo width of its bounds.
+struct DomainTile {
+    int tx, ty;            // tile coordinates
+    float x0, y0, x1, y1;  // bounds
+
+    std::vector<int> owned;            // sim.human_order indices, ascending
+    std::vector<int> halo;             // neighbours' humans near the bounds, ascending
+    std::vector<HumanTickState> local; // owned and halo states merged in id order
+    HumanGrid grid;                    // over local
+    std::vector<int> animals;          // animal_agents indices reaching into the tile, ascending
+
+    std::vector<int> outbox;           // migration scratch: humans leaving this tile
+    std::vector<int> inbox;            // ...and humans arriving
+
+    // Append the animal_agents indices of the tile's animals whose circle contains (x, y),
+    // ascending (same test and order as the world-wide contact indexes)
+    void animal_contacts(float x, float y, const std::vector<std::unique_ptr<AnimalPresence>>& all,
+                         std::vector<int>& out) const;
+};
+
+// Domain-decomposed update phase: the plane is cut into square tiles of tile_size model
+// units, each updated as one task. Tiles exist only where humans are (indexed by tile
+// coordinates), so any extent works and memory follows the occupied area. Humans that cross a
+// tile boundary migrate to the new owner, and tiles left empty are dropped; every tick each
+// tile then pulls its halo from the tiles around it. The halo width is the larger of
+// CONTACT_NETWORK_PROXIMITY_THRESHOLD and the largest animal radius, so every proximity
+// query near an edge is answered from the tile's own data.
+class DomainDecomposition {
+public:
+    explicit DomainDecomposition(float tile_size);
+
+    // Reassign humans whose published position left their tile (a full assignment when the
+    // population changed), then rebuild every tile's halo, local view and animal list
+    void exchange(const Simulation& sim);
+
+    std::vector<DomainTile> tiles;  // tiles that own humans, in no particular order
+    long migrations = 0;            // humans that changed owner, over the whole run
+    float halo_width = 0.0f;
+
+private:
+    float tile_size;
+    FlatMap<uint64_t, int> tile_index;          // tile coordinates -> tiles index
+    std::vector<DomainTile> spare_tiles;        // dropped tiles, reused with their capacity
+    std::vector<const Human*> assigned_order;   // sim.human_order at the last full assignment
+
+    int tile_coord(float v) const;
+    int find_tile(int tx, int ty) const;  // -1 if absent
+    int tile_at(float x, float y);        // created on demand
+    void assign_all(const Simulation& sim);
+    void migrate(const Simulation& sim);
+    void drop_empty_tiles();
+    void bucket_animals(const Simulation& sim);
+    void build_halo(const Simulation& sim, DomainTile& tile) const;
+};
+
+#endif //domain
@@ -0,0 +1,122 @@
+#include "engine.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <stdexcept>
+
+void index_humans(Simulation& sim) {
+    if (sim.humans_indexed) return;
+    auto ids = std::make_shared<std::vector<int>>();
+    ids->reserve(sim.human_agents.size());
+    sim.human_order.clear();
+    for (const auto& [id, h] : sim.human_agents) {
+        h->index = static_cast<int>(sim.human_order.size());
+        sim.human_order.push_back(h.get());
+        ids->push_back(id);
+    }
+    sim.human_ids = std::move(ids);
+    sim.humans_indexed = true;
+}
+
+void publish_human_states(Simulation& sim) {
+    sim.human_front.resize(sim.human_order.size());
+    parallel_ranges(sim.tick_pool, sim.human_order.size(), MOTION_CHUNK, [&sim](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const Human* h = sim.human_order[i];
+            int last_onset = h->sickness_records.empty() ? INT_MIN : h->sickness_records.back().start_time;
+            sim.human_front[i] = {h->index, h->location.x, h->location.y, h->status,
+                                  h->infection_model.output_hazard, last_onset};
+        }
+    });
+}
+
+void commit_human_updates(Simulation& sim) {
+    for (Human* h : sim.human_order) {
+        sim.log_likelihood_ratio += h->pending_log_likelihood_ratio;
+        h->pending_log_likelihood_ratio = 0.0;
+        sim.contact_events.insert(sim.contact_events.end(), h->pending_contact_events.begin(),
+                                  h->pending_contact_events.end());
+        h->pending_contact_events.clear();
+    }
+    // Tilted proposals are kept inside (0, 1), so an infinite or NaN weight is a bug, not a rare event
+    if (!std::isfinite(sim.log_likelihood_ratio)) {
+        throw std::runtime_error("Importance sampling log-likelihood ratio is not finite at tick "
+                                 + std::to_string(sim.time_step));
+    }
+}
+
+void update_hazards(Simulation& sim, bool draws) {
+    InfectionBatch& b = sim.infection_batch;
+    parallel_ranges(sim.tick_pool, b.size(), HAZARD_CHUNK, [&b](size_t begin, size_t end) {
+        decay_hazards(b, begin, end);
+    });
+    // A human's pairs are all in one buffer, so buffers accumulate independently
+    parallel_ranges(sim.tick_pool, sim.contact_pairs.size(), 1, [&sim, &b](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) accumulate_contacts(b, sim.contact_pairs[t]);
+    });
+    parallel_ranges(sim.tick_pool, b.size(), HAZARD_CHUNK, [&sim, &b, draws](size_t begin, size_t end) {
+        if (draws) {
+            infection_probabilities(b, user::IMPORTANCE_ANIMAL_HAZARD_TILT, begin, end);
+            infection_draws(b, sim.rng, sim.time_step, begin, end);
+        } else {
+            std::fill(b.got_sick.begin() + begin, b.got_sick.begin() + end, 0);
+            std::fill(b.log_ratio.begin() + begin, b.log_ratio.begin() + end, 0.0);
+        }
+    });
+}
+
+typedef std::map<std::string, SimulationEngine> EngineRegistry;
+
+template <class Motion, class Contacts>
+static void register_infection(EngineRegistry& registry, const std::string& key, bool random_animal_motion) {
+    registry[key] = {&PolicyEngine<Motion, Contacts, NoSpreadInfection, BayesianZoonotic>::tick, random_animal_motion};
+    registry[key + "+spread"] = {&PolicyEngine<Motion, Contacts, SpreadInfection, BayesianZoonotic>::tick, random_animal_motion};
+}
+
+template <MotionKernel HumanKernel, MotionKernel AnimalKernel>
+static void register_motion(EngineRegistry& registry, const std::string& human_model,
+                            const std::string& animal_model, bool random_animal_motion) {
+    typedef BatchedMotion<HumanKernel, AnimalKernel> Motion;
+    std::string key = human_model + "/" + animal_model;
+    register_infection<Motion, RasterContacts>(registry, key + "/raster", random_animal_motion);
+    register_infection<Motion, BvhContacts>(registry, key + "/bvh", random_animal_motion);
+}
+
+template <MotionKernel HumanKernel>
+static void register_human_motion(EngineRegistry& registry, const std::string& human_model) {
+    register_motion<HumanKernel, path_kernel>(registry, human_model, "a_path", false);
+    register_motion<HumanKernel, home_range_kernel>(registry, human_model, "a_home_range", true);
+    register_motion<HumanKernel, random_walk_kernel>(registry, human_model, "a_random_walk", true);
+}
+
+static const EngineRegistry& engine_registry() {
+    static const EngineRegistry registry = [] {
+        EngineRegistry r;
+        register_human_motion<noisy_interp_kernel>(r, "h_noisy_interp");
+        register_human_motion<gaussian_interp_kernel>(r, "h_gauss_interp");
+        register_human_motion<correlated_walk_kernel>(r, "h_crw");
+        register_human_motion<levy_flight_kernel>(r, "h_levy");
+        return r;
+    }();
+    return registry;
+}
+
+SimulationEngine find_engine(const std::string& human_motion_model, const std::string& animal_motion_model,
+                             const std::string& contact_index, bool simulate_spread) {
+    std::string key = human_motion_model + "/" + animal_motion_model + "/" + contact_index;
+    if (simulate_spread) key += "+spread";
+    auto it = engine_registry().find(key);
+    if (it == engine_registry().end()) {
+        throw std::invalid_argument("No simulation engine registered for '" + key + "'");
+    }
+    return it->second;
+}
+
+std::vector<std::string> registered_engines() {
+    std::vector<std::string> names;
+    for (const auto& [name, engine] : engine_registry()) {
+        names.push_back(name);
+    }
+    return names;
+}
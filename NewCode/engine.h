@@ -0,0 +1,290 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "agents.h"
+#include "user.h"
+#include "simulator.h"
+#include "motion.h"
+#include "profiler.h"
+#include "history.h"
+#include "parallel.h"
+#include "infection.h"
+
+// --- Model policies ---
+// A policy is a stateless struct with static member functions. PolicyEngine<Motion, Contacts,
+// Infection, Zoonotic> stitches one of each into a tick whose loops contain only direct,
+// inlinable calls.
+
+// Agents per task when a phase runs on sim.tick_pool
+const size_t MOTION_CHUNK = 4096;
+const size_t HUMAN_UPDATE_CHUNK = 256;
+const size_t HAZARD_CHUNK = 4096;
+
+// Motion: gather each population into its MotionBatch, run one kernel over it, scatter back.
+// The kernels are template arguments, so each call below is direct. Humans are moved in
+// independent ranges of sim.human_order (gather, kernel and scatter fused per range).
+template <MotionKernel HumanKernel, MotionKernel AnimalKernel>
+struct BatchedMotion {
+    static void move_humans(Simulation& sim) {
+        prepare_human_batch(sim, sim.human_batch);
+        parallel_ranges(sim.tick_pool, sim.human_batch.size(), MOTION_CHUNK, [&sim](size_t begin, size_t end) {
+            gather_humans(sim, sim.human_batch, begin, end);
+            HumanKernel(sim.human_batch, sim.rng, sim.time_step, begin, end);
+            scatter_humans(sim.human_batch, sim, begin, end);
+        });
+    }
+    static void move_animals(Simulation& sim) {
+        gather_animals(sim, sim.animal_batch);
+        AnimalKernel(sim.animal_batch, sim.rng, sim.time_step, 0, sim.animal_batch.size());
+        scatter_animals(sim.animal_batch, sim);
+    }
+};
+
+// Animal contact finders: refresh() once per tick after motion, then find() per human
+struct RasterContacts {
+    static void refresh(Simulation& sim) { sim.hazard_field.refresh(sim.animal_agents); }
+    static void find(Simulation& sim, float x, float y, std::vector<int>& out) {
+        sim.hazard_field.contacts(x, y, sim.animal_agents, out);
+    }
+};
+
+struct BvhContacts {
+    static void refresh(Simulation& sim) { sim.animal_bvh.refresh(sim.animal_agents); }
+    static void find(Simulation& sim, float x, float y, std::vector<int>& out) {
+        sim.animal_bvh.contacts(x, y, sim.animal_agents, out);
+    }
+};
+
+// Infection: every human's hazard is updated in one population-wide pass after the contact
+// phase (see infection.h); the policy says whether the pass ends in infection draws
+struct NoSpreadInfection {
+    static bool draws() { return false; }  // hazard accumulation only (SIMULATE_SPREAD = false)
+};
+
+struct SpreadInfection {
+    static bool draws() { return true; }   // SIMULATE_SPREAD = true
+};
+
+struct BayesianZoonotic {
+    static float p_zoonotic(HumanSicknessRecord& record) { return user::zoonotic_probability_model(&record); }
+};
+
+
+// --- Per-human contact and infection step, parameterized by policy ---
+
+// What a human's update looks at besides the human itself: published human states in id
+// order with a grid over them (the whole front buffer, or a domain tile's local view), and
+// the tile whose animal list replaces Contacts::find (nullptr = whole world)
+struct ContactScope {
+    const std::vector<HumanTickState>& humans;
+    const HumanGrid& grid;
+    const DomainTile* tile;
+};
+
+// Contact phase of one human: closes the contacts that ended and appends the human's animal
+// and human contacts to pairs (its own run of each, in animal_agents and index order)
+template <class Contacts>
+void find_contacts(Human& self, Simulation& sim, const ContactScope& scope, ContactPairs& pairs) {
+    // Expects Contacts::refresh (or the domain exchange) to have run for this tick's animal positions
+    if (scope.tile) {
+        scope.tile->animal_contacts(self.location.x, self.location.y, sim.animal_agents, pairs.animal);
+    } else {
+        Contacts::find(sim, self.location.x, self.location.y, pairs.animal);
+    }
+    pairs.animal_human.resize(pairs.animal.size(), self.index);
+
+    // Other humans are read from the published front buffer only (see HumanTickState).
+    // Candidates come back in index (= id) order, so contacts are visited as in a full pass.
+    // Scratch is per thread, so a tick allocates nothing once the lists have grown.
+    thread_local std::vector<int> nearby;
+    thread_local std::vector<int> in_range;
+    nearby.clear();
+    in_range.clear();
+    scope.grid.candidates(self.location.x, self.location.y, CONTACT_NETWORK_PROXIMITY_THRESHOLD, nearby);
+    for (int k : nearby) {
+        const HumanTickState& other = scope.humans[k];
+        if (other.index == self.index) continue;
+
+        float dx = self.location.x - other.x;
+        float dy = self.location.y - other.y;
+        float dist = std::sqrt(dx * dx + dy * dy);
+
+        if (dist <= CONTACT_NETWORK_PROXIMITY_THRESHOLD) {
+            auto act_it = self.active_contacts.find(other.index);
+            if (act_it != self.active_contacts.end()) {
+                act_it->second.total_proximity += dist;
+            } else {
+                HumanContactRecord record(other.index, other.status, sim.time_step, dist);
+                self.active_contacts[other.index] = record;
+            }
+            in_range.push_back(other.index);
+        }
+    }
+    pairs.human.insert(pairs.human.end(), in_range.begin(), in_range.end());
+    pairs.human_human.resize(pairs.human.size(), self.index);
+
+    // Close the active contacts with humans that are no longer in range, in index order.
+    // in_range is in index order too, so one merge pass tells them apart.
+    auto next = in_range.begin();
+    for (auto act_it = self.active_contacts.begin(); act_it != self.active_contacts.end();) {
+        int other = act_it->first;
+        while (next != in_range.end() && *next < other) next++;
+        if (next != in_range.end() && *next == other) {
+            ++act_it;
+            continue;
+        }
+        HumanContactRecord record = act_it->second;
+        act_it = self.active_contacts.erase(act_it);
+        record.end_time = sim.time_step;
+        self.contact_network[record.start_time] = record;
+        if (sim.record_contacts) {
+            self.pending_contact_events.push_back({self.index, record.other, record.start_time,
+                                                   record.end_time, record.other_status});
+        }
+    }
+}
+
+// Rest of a human's update once its hazard is up to date: sickness onset and recovery, and scoring
+template <class Zoonotic>
+void finish_update(Human& self, Simulation& sim, bool got_sick) {
+    if (got_sick && self.status != HumanStatus::SICK) {
+        self.status = HumanStatus::SICK;
+    }
+
+    if (self.status == HumanStatus::SICK && self.prev_status == HumanStatus::HEALTHY) {
+        HumanSicknessRecord record(sim.time_step, self.infection_model);
+        self.sickness_records.push_back(record);
+    }
+
+    if (self.status == HumanStatus::SICK) {
+        PhaseTimer timer(Phase::SCORING);
+        int sec_cases = self.secondary_cases(&sim);
+        if (!self.sickness_records.empty()) {
+            self.sickness_records.back().secondary_cases = sec_cases;
+            self.sickness_records.back().p_zoonotic = Zoonotic::p_zoonotic(self.sickness_records.back());
+        }
+    } else if (self.status == HumanStatus::HEALTHY && self.prev_status == HumanStatus::SICK) {
+        if (!self.sickness_records.empty()) {
+            self.sickness_records.back().end_time = sim.time_step;
+        }
+    }
+
+    self.prev_status = self.status;
+}
+
+// --- Double-buffered human update phase ---
+
+// Assign dense indices in id order (sim.human_order, sim.human_ids, Human::index) if the
+// population changed since the last call; called at the start of every tick
+void index_humans(Simulation& sim);
+// Fill sim.human_front from the humans as they stand after motion
+void publish_human_states(Simulation& sim);
+// Fold each human's pending shared outputs into the simulation, in human_agents order, so the
+// result is the same however the update phase was scheduled
+void commit_human_updates(Simulation& sim);
+
+// Population-wide hazard pass over sim.infection_batch, between the contact phase (which
+// gathers each human into the batch) and the finish phase (which scatters it back): decay,
+// accumulate the contact pairs, then (if draws) infection probabilities and draws. Touches
+// only the batch columns and pair arrays.
+void update_hazards(Simulation& sim, bool draws);
+
+template <class Contacts, class Infection, class Zoonotic>
+void update_humans(Simulation& sim) {
+    // Contact detection is timed once per tick, on the calling thread, around everything up to
+    // the hazard pass: the animal index refresh, publishing, the grid (or exchange) and the contact phase
+    {
+        PhaseTimer timer(Phase::CONTACT_DETECTION);
+        if (sim.domain) {
+            publish_human_states(sim);
+            sim.domain->exchange(sim);
+        } else {
+            Contacts::refresh(sim);
+            publish_human_states(sim);
+            sim.human_grid.build(sim.human_front, CONTACT_NETWORK_PROXIMITY_THRESHOLD);
+        }
+
+        // Contact phase: each task lists its humans' contacts in its own pair buffer and gathers
+        // their hazard state into the batch while they are in cache
+        prepare_infection_batch(sim, sim.infection_batch);
+        for (ContactPairs& pairs : sim.contact_pairs) pairs.clear();
+        if (sim.domain) {
+            // One task per tile, each looking at the humans it owns from its own local view
+            std::vector<DomainTile>& tiles = sim.domain->tiles;
+            if (sim.contact_pairs.size() < tiles.size()) sim.contact_pairs.resize(tiles.size());
+            parallel_ranges(sim.tick_pool, tiles.size(), 1, [&sim, &tiles](size_t begin, size_t end) {
+                for (size_t t = begin; t < end; t++) {
+                    ContactScope scope{tiles[t].local, tiles[t].grid, &tiles[t]};
+                    for (int i : tiles[t].owned) {
+                        find_contacts<Contacts>(*sim.human_order[i], sim, scope, sim.contact_pairs[t]);
+                        gather_infection(sim, sim.infection_batch, i, i + 1);
+                    }
+                }
+            });
+        } else {
+            size_t chunks = (sim.human_order.size() + HUMAN_UPDATE_CHUNK - 1) / HUMAN_UPDATE_CHUNK;
+            if (sim.contact_pairs.size() < chunks) sim.contact_pairs.resize(chunks);
+            parallel_ranges(sim.tick_pool, sim.human_order.size(), HUMAN_UPDATE_CHUNK, [&sim](size_t begin, size_t end) {
+                ContactScope scope{sim.human_front, sim.human_grid, nullptr};
+                ContactPairs& pairs = sim.contact_pairs[begin / HUMAN_UPDATE_CHUNK];
+                for (size_t i = begin; i < end; i++) {
+                    find_contacts<Contacts>(*sim.human_order[i], sim, scope, pairs);
+                }
+                gather_infection(sim, sim.infection_batch, begin, end);
+            });
+        }
+    }
+
+    {
+        PhaseTimer timer(Phase::INFECTION_UPDATE);
+        update_hazards(sim, Infection::draws());
+    }
+
+    parallel_ranges(sim.tick_pool, sim.human_order.size(), HUMAN_UPDATE_CHUNK, [&sim](size_t begin, size_t end) {
+        scatter_infection(sim.infection_batch, sim, begin, end);
+        for (size_t i = begin; i < end; i++) {
+            finish_update<Zoonotic>(*sim.human_order[i], sim, sim.infection_batch.got_sick[i]);
+        }
+    });
+    commit_human_updates(sim);
+}
+
+
+// --- Whole-tick engine ---
+
+template <class Motion, class Contacts, class Infection, class Zoonotic>
+struct PolicyEngine {
+    static void tick(Simulation& sim) {
+        index_humans(sim);
+        {
+            PhaseTimer timer(Phase::HUMAN_MOVE);
+            Motion::move_humans(sim);
+        }
+        {
+            PhaseTimer timer(Phase::ANIMAL_MOVE);
+            Motion::move_animals(sim);
+        }
+
+        // AnimalPresence::update() is a no-op, so there is no animal update phase
+        update_humans<Contacts, Infection, Zoonotic>(sim);
+
+        if (sim.long_horizon) {
+            prune_history(sim);
+        }
+
+        sim.time_step++;
+    }
+};
+
+// Registry of compiled policy combinations. Keys are "<human motion>/<animal motion>/<contact index>"
+// for hazard-only runs, with "+spread" appended when infections spread
+// (e.g. "h_noisy_interp/a_path/raster+spread").
+SimulationEngine find_engine(const std::string& human_motion_model, const std::string& animal_motion_model,
+                             const std::string& contact_index, bool simulate_spread);
+std::vector<std::string> registered_engines();
+
+#endif //engine
@@ -0,0 +1,62 @@
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Ordered map stored as a sorted vector of (key, value) pairs: the subset of the std::map
+// interface the agents use, with the same iteration order and overwrite semantics. Inserts
+// shift the tail instead of allocating a node, and copy assignment reuses the capacity the
+// target already has, so a map that is reset between trials stops allocating once it has
+// grown to its working size.
+template <class Key, class Value>
+class FlatMap {
+public:
+    typedef std::pair<Key, Value> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    iterator begin() { return this->items.begin(); }
+    iterator end() { return this->items.end(); }
+    const_iterator begin() const { return this->items.begin(); }
+    const_iterator end() const { return this->items.end(); }
+    size_t size() const { return this->items.size(); }
+    bool empty() const { return this->items.empty(); }
+    void clear() { this->items.clear(); }
+
+    iterator lower_bound(const Key& key) {
+        return std::lower_bound(this->items.begin(), this->items.end(), key,
+                                [](const value_type& item, const Key& k) { return item.first < k; });
+    }
+    const_iterator lower_bound(const Key& key) const {
+        return std::lower_bound(this->items.begin(), this->items.end(), key,
+                                [](const value_type& item, const Key& k) { return item.first < k; });
+    }
+
+    iterator find(const Key& key) {
+        iterator it = this->lower_bound(key);
+        return it != this->items.end() && it->first == key ? it : this->items.end();
+    }
+    const_iterator find(const Key& key) const {
+        const_iterator it = this->lower_bound(key);
+        return it != this->items.end() && it->first == key ? it : this->items.end();
+    }
+    size_t count(const Key& key) const { return this->find(key) != this->items.end() ? 1 : 0; }
+
+    Value& operator[](const Key& key) {
+        iterator it = this->lower_bound(key);
+        if (it == this->items.end() || it->first != key) {
+            it = this->items.insert(it, value_type(key, Value()));
+        }
+        return it->second;
+    }
+
+    iterator erase(const_iterator pos) { return this->items.erase(pos); }
+    iterator erase(const_iterator first, const_iterator last) { return this->items.erase(first, last); }
+
+private:
+    std::vector<value_type> items;
+};
+
+#endif //flat_map
@@ -0,0 +1,104 @@
+#include "hazard_field.h"
+#include "agents.h"
+#include "simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Slack on the cell/circle classification: cells must lie this far inside a circle to skip the
+// distance test, and cells this close outside still get an entry, so float rounding at the
+// boundary is always left to the exact test
+const float INTERIOR_MARGIN = 0.01f;
+
+// Cells per radius once the largest animal outgrows the minimum cell size
+const float CELLS_PER_RADIUS = 8.0f;
+
+HazardField::HazardField(float cell_size)
+    : min_cell_size(cell_size),
+      cell_size(cell_size) {}
+
+bool HazardField::AnimalKey::operator==(const AnimalKey& o) const {
+    return x == o.x && y == o.y && radius == o.radius && hazard == o.hazard;
+}
+
+// Same test as the brute-force pass it replaces, so results are bit-identical
+static inline bool in_circle(float x, float y, const AnimalPresence& a) {
+    float dx = x - a.location.x;
+    float dy = y - a.location.y;
+    return std::sqrt(dx * dx + dy * dy) <= a.radius;
+}
+
+bool HazardField::refresh(const std::vector<std::unique_ptr<AnimalPresence>>& animals) {
+    bool changed = !this->built || animals.size() != this->built_from.size();
+    for (size_t i = 0; i < animals.size() && !changed; i++) {
+        const AnimalPresence& a = *animals[i];
+        AnimalKey key{a.location.x, a.location.y, a.radius, a.infection_model.output_hazard};
+        changed = !(key == this->built_from[i]);
+    }
+    if (changed) {
+        this->rebuild(animals);
+    }
+    return changed;
+}
+
+void HazardField::rebuild(const std::vector<std::unique_ptr<AnimalPresence>>& animals) {
+    this->built_from.resize(animals.size());
+    float max_radius = 0.0f;
+    for (const auto& a : animals) {
+        if (a->infection_model.output_hazard != 0.0f) max_radius = std::max(max_radius, a->radius);
+    }
+    this->cell_size = std::max(this->min_cell_size, max_radius / CELLS_PER_RADIUS);
+
+    // Animals are visited in order, so each cell's entries come out in animal_agents order
+    this->cells.clear();
+    this->visits.clear();
+    for (size_t i = 0; i < animals.size(); i++) {
+        const AnimalPresence& a = *animals[i];
+        if (a.infection_model.output_hazard == 0.0f) continue;
+
+        float ax = a.location.x, ay = a.location.y, r = a.radius;
+        float margin = INTERIOR_MARGIN + 1e-5f * (std::fabs(ax) + std::fabs(ay) + r);  // float spacing grows with magnitude
+        float outer = r + margin, inner = r - margin;
+        int c0 = CellHash::coord(ax - outer, this->cell_size), c1 = CellHash::coord(ax + outer, this->cell_size);
+        int r0 = CellHash::coord(ay - outer, this->cell_size), r1 = CellHash::coord(ay + outer, this->cell_size);
+
+        for (int row = r0; row <= r1; row++) {
+            float y0 = row * this->cell_size, y1 = y0 + this->cell_size;
+            for (int col = c0; col <= c1; col++) {
+                float x0 = col * this->cell_size, x1 = x0 + this->cell_size;
+
+                // Nearest and farthest points of the cell from the centre
+                float nx = std::clamp(ax, x0, x1) - ax, ny = std::clamp(ay, y0, y1) - ay;
+                if (nx * nx + ny * ny > outer * outer) continue;
+                float fx = std::max(ax - x0, x1 - ax), fy = std::max(ay - y0, y1 - ay);
+                bool covered = inner > 0.0f && fx * fx + fy * fy <= inner * inner;
+
+                this->visits.push_back({this->cells.add(col, row), {static_cast<int>(i), !covered}});
+            }
+        }
+    }
+
+    this->entries.resize(this->cells.finish());
+    for (const Visit& v : this->visits) {
+        this->entries[this->cells.next_slot(v.cell)] = v.entry;
+    }
+
+    for (size_t i = 0; i < animals.size(); i++) {
+        const AnimalPresence& a = *animals[i];
+        this->built_from[i] = {a.location.x, a.location.y, a.radius, a.infection_model.output_hazard};
+    }
+    this->built = true;
+    this->rebuilds++;
+}
+
+void HazardField::contacts(float x, float y, const std::vector<std::unique_ptr<AnimalPresence>>& animals,
+                           std::vector<int>& out) const {
+    int begin, end;
+    this->cells.range(CellHash::coord(x, this->cell_size), CellHash::coord(y, this->cell_size), begin, end);
+    for (int k = begin; k < end; k++) {
+        const CellEntry& e = this->entries[k];
+        if (!e.edge || in_circle(x, y, *animals[e.animal])) {
+            out.push_back(e.animal);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef HAZARD_FIELD_H
+#define HAZARD_FIELD_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "cell_hash.h"
+
+class AnimalPresence;
+
+// Sparse raster of animal circles. Each cell lists, in
+// animal_agents order, the hazard-emitting animals whose circle touches it, flagged as
+// covering the whole cell (no distance test needed) or crossing it (exact test needed).
+// Looking up a human's animal contacts is then one cell read instead of a pass over every
+// animal. The raster is only rebuilt when an animal moves, resizes or changes hazard. Only
+// cells touched by a circle are stored (hashed), so the world has no extent; cells grow with
+// the largest radius so one animal never covers more than about 17 x 17 of them.
+class HazardField {
+public:
+    explicit HazardField(float cell_size = 10.0f);
+
+    // Rebuild the raster if the animals differ from the last build; returns true if it rebuilt
+    bool refresh(const std::vector<std::unique_ptr<AnimalPresence>>& animals);
+
+    // Append the animal_agents indices of the animals whose circle contains (x, y), ascending.
+    // Animals with zero hazard are never reported, since they contribute nothing to exposure.
+    void contacts(float x, float y, const std::vector<std::unique_ptr<AnimalPresence>>& animals,
+                  std::vector<int>& out) const;
+
+    long rebuilds = 0;
+
+private:
+    struct CellEntry {
+        int animal;   // index into animal_agents
+        bool edge;    // circle boundary crosses the cell: test the exact distance
+    };
+
+    struct AnimalKey {
+        float x, y, radius, hazard;
+        bool operator==(const AnimalKey& o) const;
+    };
+
+    struct Visit {
+        int cell;
+        CellEntry entry;
+    };
+
+    float min_cell_size;
+    float cell_size;
+    CellHash cells;
+    std::vector<CellEntry> entries;
+    std::vector<Visit> visits;        // rebuild scratch
+    std::vector<AnimalKey> built_from;
+    bool built = false;
+
+    void rebuild(const std::vector<std::unique_ptr<AnimalPresence>>& animals);
+};
+
+#endif //hazard_field
@@ -0,0 +1,45 @@
+#include "history.h"
+#include "agents.h"
+#include "simulator.h"
+
+#include <algorithm>
+#include <climits>
+#include <iterator>
+
+int contact_horizon(const Human& human, int next_tick) {
+    int onset = next_tick;
+    if (human.status == HumanStatus::SICK && !human.sickness_records.empty()) {
+        onset = human.sickness_records.back().start_time;
+    }
+    return onset - INCUBATION_SIM_TIME;
+}
+
+void prune_history(Simulation& sim) {
+    int next_tick = sim.time_step + 1;
+    int oldest_horizon = INT_MAX;
+
+    // contact_network is keyed by start time, so the expired contacts are a prefix of the map
+    for (auto& [id, h] : sim.human_agents) {
+        int horizon = contact_horizon(*h, next_tick);
+        oldest_horizon = std::min(oldest_horizon, horizon);
+
+        auto keep = h->contact_network.lower_bound(horizon);
+        h->evicted_contacts += std::distance(h->contact_network.begin(), keep);
+        h->contact_network.erase(h->contact_network.begin(), keep);
+    }
+
+    // Other humans' sickness onsets are compared against every horizon; the latest record
+    // is kept regardless because it is still being updated and feeds get_results()
+    for (auto& [id, h] : sim.human_agents) {
+        auto& records = h->sickness_records;
+        size_t expired = 0;
+        while (expired + 1 < records.size() && records[expired].start_time < oldest_horizon) {
+            h->evicted_secondary_cases += records[expired].secondary_cases;
+            expired++;
+        }
+        if (expired > 0) {
+            h->evicted_sickness_records += static_cast<int>(expired);
+            records.erase(records.begin(), records.begin() + expired);
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+class Human;
+class Simulation;
+
+// Long-horizon mode. secondary_cases() only looks at contacts that started at most
+// INCUBATION_SIM_TIME before the onset of the current sickness, so anything older can never
+// affect a result again. Pruning it every tick keeps memory proportional to the contacts and
+// sicknesses inside that window instead of to elapsed time. What is dropped is folded into
+// per-human counters, so get_results() is unchanged.
+
+// Earliest contact start time that can still count toward a secondary case of this human,
+// in its current sickness or any sickness starting at next_tick or later
+int contact_horizon(const Human& human, int next_tick);
+
+// Drop contacts older than each human's horizon, and sickness records (except each human's
+// latest) older than every human's horizon. Call at the end of a tick.
+void prune_history(Simulation& sim);
+
+#endif //history
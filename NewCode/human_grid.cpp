@@ -0,0 +1,35 @@
+#include "human_grid.h"
+#include "simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+void HumanGrid::build(const std::vector<HumanTickState>& front, float min_cell) {
+    int n = static_cast<int>(front.size());
+    this->cell_size = std::max(min_cell, 1e-3f);
+    this->cells.clear();
+
+    // Two passes in front order, so each cell's entries come out ascending
+    this->cell_of.resize(n);
+    for (int i = 0; i < n; i++) {
+        this->cell_of[i] = this->cells.add(CellHash::coord(front[i].x, this->cell_size),
+                                           CellHash::coord(front[i].y, this->cell_size));
+    }
+    this->entries.resize(this->cells.finish());
+    for (int i = 0; i < n; i++) {
+        this->entries[this->cells.next_slot(this->cell_of[i])] = i;
+    }
+}
+
+void HumanGrid::candidates(float x, float y, float radius, std::vector<int>& out) const {
+    // Padded so float rounding in the caller's distance test can never reach a cell we skip
+    float r = radius + 0.01f + 1e-5f * (std::fabs(x) + std::fabs(y) + radius);
+    int cx0 = CellHash::coord(x - r, this->cell_size), cx1 = CellHash::coord(x + r, this->cell_size);
+    int cy0 = CellHash::coord(y - r, this->cell_size), cy1 = CellHash::coord(y + r, this->cell_size);
+
+    size_t first = out.size();
+    this->cells.for_each_range(cx0, cx1, cy0, cy1, [&](int begin, int end) {
+        out.insert(out.end(), this->entries.begin() + begin, this->entries.begin() + end);
+    });
+    std::sort(out.begin() + first, out.end());
+}
@@ -0,0 +1,29 @@
+#ifndef HUMAN_GRID_H
+#define HUMAN_GRID_H
+
+#include <vector>
+#include "cell_hash.h"
+
+struct HumanTickState;
+
+// Grid over the published human positions (see HumanTickState), rebuilt every tick. Cells
+// are at least the contact radius wide, so a human's contacts are found in the block of
+// cells around it instead of by a pass over the whole population. Cells are hashed, so the
+// grid costs memory per occupied cell wherever the humans are.
+class HumanGrid {
+public:
+    // Bin front[i] by position; cells are at least min_cell wide
+    void build(const std::vector<HumanTickState>& front, float min_cell);
+
+    // Append, in ascending order, the front indices of humans that may be within radius of
+    // (x, y). Every human within radius is reported; a few farther ones may be too.
+    void candidates(float x, float y, float radius, std::vector<int>& out) const;
+
+private:
+    float cell_size = 1.0f;
+    CellHash cells;
+    std::vector<int> entries;  // front indices, ascending within each cell
+    std::vector<int> cell_of;  // build scratch
+};
+
+#endif //human_grid
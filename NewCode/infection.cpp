@@ -0,0 +1,130 @@
+#include "infection.h"
+#include "agents.h"
+#include "simulator.h"
+#include "user.h"
+
+#include <algorithm>
+#include <cmath>
+
+// The kernels below are the only implementation of the infection model; its parameters
+// (hazard decay, human output hazards, importance tilt) live in user::.
+
+void InfectionBatch::resize(size_t humans, size_t animals) {
+    this->ids.resize(humans);
+    this->sick.resize(humans);
+    this->published.resize(humans);
+    this->output.resize(humans);
+    this->animal.resize(humans);
+    this->human.resize(humans);
+    this->p_sick.resize(humans);
+    this->q_sick.resize(humans);
+    this->got_sick.resize(humans);
+    this->log_ratio.resize(humans);
+    this->animal_output.resize(animals);
+}
+
+void ContactPairs::clear() {
+    this->animal_human.clear();
+    this->animal.clear();
+    this->human_human.clear();
+    this->human.clear();
+}
+
+void prepare_infection_batch(const Simulation& sim, InfectionBatch& b) {
+    b.resize(sim.human_order.size(), sim.animal_agents.size());
+    for (size_t k = 0; k < sim.animal_agents.size(); k++) {
+        b.animal_output[k] = sim.animal_agents[k]->infection_model.output_hazard;
+    }
+}
+
+void gather_infection(const Simulation& sim, InfectionBatch& b, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        const Human* h = sim.human_order[i];
+        b.ids[i] = h->id;
+        b.sick[i] = h->status == HumanStatus::SICK;
+        b.published[i] = sim.human_front[i].output_hazard;
+        b.animal[i] = h->infection_model.experienced_animal_hazard;
+        b.human[i] = h->infection_model.experienced_human_hazard;
+    }
+}
+
+void decay_hazards(InfectionBatch& b, size_t begin, size_t end) {
+    const float decay = user::HAZARD_DECAY;
+    const float healthy = user::HUMAN_HAZARD_HEALTHY, sick = user::HUMAN_HAZARD_SICK;
+    float* out = b.output.data();
+    float* animal = b.animal.data();
+    float* human = b.human.data();
+    const uint8_t* is_sick = b.sick.data();
+    for (size_t i = begin; i < end; i++) {
+        out[i] = is_sick[i] ? sick : healthy;
+        animal[i] *= decay;
+        human[i] *= decay;
+    }
+}
+
+void accumulate_contacts(InfectionBatch& b, const ContactPairs& pairs) {
+    float* animal = b.animal.data();
+    float* human = b.human.data();
+    const float* animal_output = b.animal_output.data();
+    const float* published = b.published.data();
+    for (size_t k = 0; k < pairs.animal.size(); k++) {
+        animal[pairs.animal_human[k]] += animal_output[pairs.animal[k]];
+    }
+    for (size_t k = 0; k < pairs.human.size(); k++) {
+        human[pairs.human_human[k]] += published[pairs.human[k]];
+    }
+}
+
+// A tilted proposal stays strictly inside (0, 1) wherever p does, so both outcomes keep a
+// finite log-ratio; where p is 0 or 1 the draw can't change the outcome and is not tilted
+static const double MIN_PROPOSAL = 1e-12;
+static const double MAX_PROPOSAL = 1.0 - 1e-12;
+
+void infection_probabilities(InfectionBatch& b, float animal_tilt, size_t begin, size_t end) {
+    const float* animal = b.animal.data();
+    const float* human = b.human.data();
+    double* p = b.p_sick.data();
+    double* q = b.q_sick.data();
+    for (size_t i = begin; i < end; i++) {
+        p[i] = -std::expm1(-(static_cast<double>(animal[i]) + human[i]));
+    }
+    if (animal_tilt == 1.0f) {
+        for (size_t i = begin; i < end; i++) q[i] = p[i];
+        return;
+    }
+
+    // Only draws that can change the outcome (healthy humans) are tilted
+    const uint8_t* is_sick = b.sick.data();
+    for (size_t i = begin; i < end; i++) {
+        if (is_sick[i] || p[i] <= 0.0 || p[i] >= 1.0) {
+            q[i] = p[i];
+            continue;
+        }
+        double tilted = -std::expm1(-(static_cast<double>(animal_tilt) * animal[i] + human[i]));
+        q[i] = std::min(std::max(tilted, MIN_PROPOSAL), MAX_PROPOSAL);
+    }
+}
+
+void infection_draws(InfectionBatch& b, const SimRandom& rng, int tick, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        double u = rng.uniform(b.ids[i], tick, RandomStream::INFECTION);
+        bool got_sick = u < b.q_sick[i];
+        b.got_sick[i] = got_sick;
+
+        b.log_ratio[i] = 0.0;
+        if (b.q_sick[i] != b.p_sick[i]) {
+            double p = b.p_sick[i], q = b.q_sick[i];
+            b.log_ratio[i] = got_sick ? std::log(p / q) : std::log1p(-p) - std::log1p(-q);
+        }
+    }
+}
+
+void scatter_infection(const InfectionBatch& b, Simulation& sim, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        Human* h = sim.human_order[i];
+        h->infection_model.output_hazard = b.output[i];
+        h->infection_model.experienced_animal_hazard = b.animal[i];
+        h->infection_model.experienced_human_hazard = b.human[i];
+        h->pending_log_likelihood_ratio += b.log_ratio[i];
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef INFECTION_H
+#define INFECTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "random.h"
+
+class Simulation;
+
+// --- Structure-of-arrays hazard state of the human population for a tick ---
+// Gathered from the humans (by dense index) once the contact phase has run, updated by the
+// kernels below as whole columns, and scattered back before sickness records are taken, so
+// the infection step reads contact hazards from flat arrays instead of chasing an agent
+// pointer per contact. Buffers are owned by the Simulation and keep their capacity.
+struct InfectionBatch {
+    std::vector<int> ids;              // keys of the infection draws
+    std::vector<uint8_t> sick;         // status after motion: 1 if SICK
+    std::vector<float> published;      // output hazard as published at the start of the tick
+    std::vector<float> output;         // output hazard for this tick (by status)
+    std::vector<float> animal;         // experienced animal hazard
+    std::vector<float> human;          // experienced human hazard
+    std::vector<double> p_sick;        // 1 - exp(-(animal + human))
+    std::vector<double> q_sick;        // draw threshold (tilted toward animal hazard for healthy humans)
+    std::vector<uint8_t> got_sick;
+    std::vector<double> log_ratio;     // log(p/q) term of the draw, 0 if untilted
+    std::vector<float> animal_output;  // output hazard by animal_agents index
+
+    void resize(size_t humans, size_t animals);
+    size_t size() const { return this->ids.size(); }
+};
+
+// The contacts one task of the contact phase found, as index pairs. Pairs of a human are
+// contiguous and in the order its contacts were found, so accumulating them reproduces the
+// per-human sums exactly; a human's pairs are all in one task's buffer.
+struct ContactPairs {
+    std::vector<int> animal_human;  // dense human index...
+    std::vector<int> animal;        // ...and the animal_agents index it touches
+    std::vector<int> human_human;   // dense human index...
+    std::vector<int> human;         // ...and the dense index of the other human
+
+    void clear();
+};
+
+// Kernels, in tick order. Ranges are of dense human indices; disjoint ranges (and disjoint
+// pair buffers) may run concurrently.
+void prepare_infection_batch(const Simulation& sim, InfectionBatch& batch);
+void gather_infection(const Simulation& sim, InfectionBatch& batch, size_t begin, size_t end);
+void decay_hazards(InfectionBatch& batch, size_t begin, size_t end);
+void accumulate_contacts(InfectionBatch& batch, const ContactPairs& pairs);
+void infection_probabilities(InfectionBatch& batch, float animal_tilt, size_t begin, size_t end);
+void infection_draws(InfectionBatch& batch, const SimRandom& rng, int tick, size_t begin, size_t end);
+void scatter_infection(const InfectionBatch& batch, Simulation& sim, size_t begin, size_t end);
+
+#endif //infection
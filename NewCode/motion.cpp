@@ -0,0 +1,231 @@
+#include "motion.h"
+#include "agents.h"
+#include "simulator.h"
+
+#include <cmath>
+#include <algorithm>
+
+// --- Motion model parameters (per tick, in grid units) ---
+const int NOISY_INTERP_MAX_NOISE = 8;
+const float GAUSSIAN_JITTER_SD = 4.0f;
+const float CRW_SPEED = 4.0f;
+const float CRW_TURN_SD = 0.5f;           // radians
+const float CRW_PERSISTENCE = 0.9f;       // heading decays toward the drift direction by this factor
+const float LEVY_MIN_STEP = 1.0f;
+const float LEVY_MAX_STEP = 60.0f;
+const float LEVY_ALPHA = 1.5f;            // tail exponent of the step-length distribution
+const float HOME_RANGE_PULL = 0.05f;      // fraction of the offset from home recovered per tick
+const float HOME_RANGE_SD = 3.0f;
+const float RANDOM_WALK_SD = 3.0f;
+
+const float TWO_PI = 6.28318530717958647692f;
+
+void MotionBatch::resize(size_t n) {
+    this->ids.resize(n);
+    this->x.resize(n);
+    this->y.resize(n);
+    this->drift_x.resize(n);
+    this->drift_y.resize(n);
+    this->heading.resize(n);
+    this->home_x.resize(n);
+    this->home_y.resize(n);
+    this->free.resize(n);
+}
+
+// Pair of independent standard normals (Box-Muller) from two uniform slots. The radius is
+// taken in double: u is in [0, 1) but may round to 1.0f, and log(0) would put the agent at inf.
+static inline void normal_pair(const SimRandom& rng, int id, int tick, RandomStream s1, RandomStream s2,
+                               float& n1, float& n2) {
+    float r = static_cast<float>(std::sqrt(-2.0 * std::log1p(-rng.uniform(id, tick, s1))));
+    float theta = TWO_PI * static_cast<float>(rng.uniform(id, tick, s2));
+    n1 = r * std::cos(theta);
+    n2 = r * std::sin(theta);
+}
+
+
+// --- Human kernels ---
+
+void noisy_interp_kernel(MotionBatch& b, const SimRandom& rng, int tick, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        int noise_x = rng.uniform_int(b.ids[i], tick, b.stream_x, -NOISY_INTERP_MAX_NOISE, NOISY_INTERP_MAX_NOISE);
+        int noise_y = rng.uniform_int(b.ids[i], tick, b.stream_y, -NOISY_INTERP_MAX_NOISE, NOISY_INTERP_MAX_NOISE);
+        float nx = b.x[i] + (b.drift_x[i] + static_cast<float>(noise_x));
+        float ny = b.y[i] + (b.drift_y[i] + static_cast<float>(noise_y));
+        b.x[i] = b.free[i] ? nx : b.x[i];
+        b.y[i] = b.free[i] ? ny : b.y[i];
+    }
+}
+
+void gaussian_interp_kernel(MotionBatch& b, const SimRandom& rng, int tick, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        float jx, jy;
+        normal_pair(rng, b.ids[i], tick, b.stream_x, b.stream_y, jx, jy);
+        float nx = b.x[i] + b.drift_x[i] + GAUSSIAN_JITTER_SD * jx;
+        float ny = b.y[i] + b.drift_y[i] + GAUSSIAN_JITTER_SD * jy;
+        b.x[i] = b.free[i] ? nx : b.x[i];
+        b.y[i] = b.free[i] ? ny : b.y[i];
+    }
+}
+
+void correlated_walk_kernel(MotionBatch& b, const SimRandom& rng, int tick, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        float turn, unused;
+        normal_pair(rng, b.ids[i], tick, b.stream_turn, b.stream_step, turn, unused);
+        float h = CRW_PERSISTENCE * b.heading[i] + CRW_TURN_SD * turn;
+
+        // Heading is measured from the drift direction (east when there is no drift)
+        float len = std::sqrt(b.drift_x[i] * b.drift_x[i] + b.drift_y[i] * b.drift_y[i]);
+        float ux = len > 0.0f ? b.drift_x[i] / len : 1.0f;
+        float uy = len > 0.0f ? b.drift_y[i] / len : 0.0f;
+        float c = std::cos(h), s = std::sin(h);
+        float nx = b.x[i] + b.drift_x[i] + CRW_SPEED * (ux * c - uy * s);
+        float ny = b.y[i] + b.drift_y[i] + CRW_SPEED * (ux * s + uy * c);
+
+        b.x[i] = b.free[i] ? nx : b.x[i];
+        b.y[i] = b.free[i] ? ny : b.y[i];
+        b.heading[i] = b.free[i] ? h : b.heading[i];
+    }
+}
+
+void levy_flight_kernel(MotionBatch& b, const SimRandom& rng, int tick, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        // Pareto step length, truncated so one tick can't cross the world (1 - u in double, as above)
+        float tail = static_cast<float>(1.0 - rng.uniform(b.ids[i], tick, b.stream_step));
+        float step = std::min(LEVY_MIN_STEP * std::pow(tail, -1.0f / LEVY_ALPHA), LEVY_MAX_STEP);
+        float theta = TWO_PI * static_cast<float>(rng.uniform(b.ids[i], tick, b.stream_turn));
+        float nx = b.x[i] + b.drift_x[i] + step * std::cos(theta);
+        float ny = b.y[i] + b.drift_y[i] + step * std::sin(theta);
+        b.x[i] = b.free[i] ? nx : b.x[i];
+        b.y[i] = b.free[i] ? ny : b.y[i];
+    }
+}
+
+
+// --- Animal kernels ---
+
+void path_kernel(MotionBatch& b, const SimRandom&, int, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        float nx = b.x[i] + b.drift_x[i];
+        float ny = b.y[i] + b.drift_y[i];
+        b.x[i] = b.free[i] ? nx : b.x[i];
+        b.y[i] = b.free[i] ? ny : b.y[i];
+    }
+}
+
+void home_range_kernel(MotionBatch& b, const SimRandom& rng, int tick, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        float jx, jy;
+        normal_pair(rng, b.ids[i], tick, b.stream_x, b.stream_y, jx, jy);
+        float nx = b.x[i] + b.drift_x[i] + HOME_RANGE_PULL * (b.home_x[i] - b.x[i]) + HOME_RANGE_SD * jx;
+        float ny = b.y[i] + b.drift_y[i] + HOME_RANGE_PULL * (b.home_y[i] - b.y[i]) + HOME_RANGE_SD * jy;
+        b.x[i] = b.free[i] ? nx : b.x[i];
+        b.y[i] = b.free[i] ? ny : b.y[i];
+    }
+}
+
+void random_walk_kernel(MotionBatch& b, const SimRandom& rng, int tick, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        float jx, jy;
+        normal_pair(rng, b.ids[i], tick, b.stream_x, b.stream_y, jx, jy);
+        float nx = b.x[i] + b.drift_x[i] + RANDOM_WALK_SD * jx;
+        float ny = b.y[i] + b.drift_y[i] + RANDOM_WALK_SD * jy;
+        b.x[i] = b.free[i] ? nx : b.x[i];
+        b.y[i] = b.free[i] ? ny : b.y[i];
+    }
+}
+
+
+// --- Gather / scatter ---
+
+void prepare_human_batch(const Simulation& sim, MotionBatch& b) {
+    b.resize(sim.human_order.size());
+    b.stream_x = RandomStream::MOTION_X;
+    b.stream_y = RandomStream::MOTION_Y;
+    b.stream_turn = RandomStream::MOTION_TURN;
+    b.stream_step = RandomStream::MOTION_STEP;
+}
+
+void gather_humans(Simulation& sim, MotionBatch& b, size_t begin, size_t end) {
+    int t = sim.time_step;
+    for (size_t i = begin; i < end; i++) {
+        Human* h = sim.human_order[i];
+        b.ids[i] = h->id;
+        b.heading[i] = h->heading;
+        b.drift_x[i] = 0.0f;
+        b.drift_y[i] = 0.0f;
+        b.free[i] = 0;
+
+        // Keyframes pin the position; between keyframes the agent drifts toward the next one
+        // (re-aimed every tick, since the kernels add noise on top of the drift)
+        const PathSegment* seg = h->location_path.seek(t);
+        if (seg && seg->start_time == t) {
+            h->location = seg->start;
+        } else if (seg && (seg->start_time > t || seg->end_time != PATH_END)) {
+            int next_time = seg->start_time > t ? seg->start_time : seg->end_time;
+            const LocationRecord& next = seg->start_time > t ? seg->start : seg->end;
+            float dt = static_cast<float>(next_time - t);
+            b.drift_x[i] = (next.x - h->location.x) / dt;
+            b.drift_y[i] = (next.y - h->location.y) / dt;
+            b.free[i] = 1;
+        }
+        b.x[i] = h->location.x;
+        b.y[i] = h->location.y;
+    }
+}
+
+void scatter_humans(const MotionBatch& b, Simulation& sim, size_t begin, size_t end) {
+    int t = sim.time_step;
+    for (size_t i = begin; i < end; i++) {
+        Human* h = sim.human_order[i];
+        h->location.x = b.x[i];
+        h->location.y = b.y[i];
+        h->heading = b.heading[i];
+
+        auto rit = h->self_reports.find(t);
+        if (rit != h->self_reports.end()) {
+            h->status = rit->second;
+        }
+    }
+}
+
+void gather_animals(Simulation& sim, MotionBatch& b) {
+    int t = sim.time_step;
+    b.resize(sim.animal_agents.size());
+    b.stream_x = RandomStream::ANIMAL_MOTION_X;
+    b.stream_y = RandomStream::ANIMAL_MOTION_Y;
+    b.stream_turn = RandomStream::ANIMAL_MOTION_TURN;
+    b.stream_step = RandomStream::ANIMAL_MOTION_STEP;
+
+    for (size_t i = 0; i < sim.animal_agents.size(); i++) {
+        AnimalPresence& a = *sim.animal_agents[i];
+        b.drift_x[i] = 0.0f;
+        b.drift_y[i] = 0.0f;
+        b.free[i] = 1;
+
+        // Keyframes pin the position; inside a migration segment the drift is its precomputed velocity
+        const PathSegment* seg = a.migration_path.seek(t);
+        if (seg && seg->start_time == t) {
+            a.location = seg->start;
+            b.free[i] = 0;
+        } else if (seg && seg->start_time < t) {
+            b.drift_x[i] = seg->vx;
+            b.drift_y[i] = seg->vy;
+        }
+
+        b.ids[i] = a.id;
+        b.x[i] = a.location.x;
+        b.y[i] = a.location.y;
+        b.heading[i] = a.heading;
+        b.home_x[i] = a.home.x;
+        b.home_y[i] = a.home.y;
+    }
+}
+
+void scatter_animals(const MotionBatch& b, Simulation& sim) {
+    for (size_t i = 0; i < sim.animal_agents.size(); i++) {
+        AnimalPresence& a = *sim.animal_agents[i];
+        a.location.x = b.x[i];
+        a.location.y = b.y[i];
+        a.heading = b.heading[i];
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "random.h"
+
+class Simulation;
+
+// --- Structure-of-arrays view of one population's positions for a tick ---
+// Gathered from the agents before the motion kernel runs and scattered back after it, so a
+// kernel is a single loop over flat float arrays instead of one function call per agent.
+// Buffers are owned by the Simulation and keep their capacity between ticks.
+struct MotionBatch {
+    std::vector<int> ids;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> drift_x;   // per-tick velocity toward the next keyframe (0 if none)
+    std::vector<float> drift_y;
+    std::vector<float> heading;   // persistent turning state of correlated walks (radians, relative to drift)
+    std::vector<float> home_x;    // centre of an animal's home range
+    std::vector<float> home_y;
+    std::vector<uint8_t> free;    // 1 if the kernel may move the agent this tick, 0 if pinned to a keyframe
+
+    // Draw slots for this population (humans and animals use disjoint streams)
+    RandomStream stream_x;
+    RandomStream stream_y;
+    RandomStream stream_turn;
+    RandomStream stream_step;
+
+    void resize(size_t n);
+    size_t size() const { return this->x.size(); }
+};
+
+// A motion kernel advances every free agent in [begin, end) of a batch by one tick. Agents
+// are independent (draws are keyed by agent id), so disjoint ranges may run concurrently.
+typedef void (*MotionKernel)(MotionBatch& batch, const SimRandom& rng, int tick, size_t begin, size_t end);
+
+// Human models (drift follows the keyframes of location_history)
+void noisy_interp_kernel(MotionBatch& batch, const SimRandom& rng, int tick, size_t begin, size_t end);       // h_noisy_interp: uniform integer noise
+void gaussian_interp_kernel(MotionBatch& batch, const SimRandom& rng, int tick, size_t begin, size_t end);    // h_gauss_interp: Gaussian jitter
+void correlated_walk_kernel(MotionBatch& batch, const SimRandom& rng, int tick, size_t begin, size_t end);    // h_crw: persistent heading around the drift
+void levy_flight_kernel(MotionBatch& batch, const SimRandom& rng, int tick, size_t begin, size_t end);        // h_levy: heavy-tailed step lengths
+
+// Animal models (drift is the velocity of the current migration_pattern segment)
+void path_kernel(MotionBatch& batch, const SimRandom& rng, int tick, size_t begin, size_t end);               // a_path: follow the migration path exactly
+void home_range_kernel(MotionBatch& batch, const SimRandom& rng, int tick, size_t begin, size_t end);         // a_home_range: mean-reverting wander
+void random_walk_kernel(MotionBatch& batch, const SimRandom& rng, int tick, size_t begin, size_t end);        // a_random_walk: Brownian steps
+
+// Copy agent state into a batch (applying keyframes) and back out again (applying self reports).
+// Humans are handled by range of sim.human_order, after prepare_human_batch sized the batch.
+void prepare_human_batch(const Simulation& sim, MotionBatch& batch);
+void gather_humans(Simulation& sim, MotionBatch& batch, size_t begin, size_t end);
+void scatter_humans(const MotionBatch& batch, Simulation& sim, size_t begin, size_t end);
+void gather_animals(Simulation& sim, MotionBatch& batch);
+void scatter_animals(const MotionBatch& batch, Simulation& sim);
+
+#endif //motion
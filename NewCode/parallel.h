@@ -0,0 +1,25 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include "scheduler.h"
+
+// Run body(begin, end) over consecutive chunks of [0, n): on the pool when there is one and
+// more than one chunk, otherwise inline and in order. A body may only write state owned by
+// its own range; anything shared is reduced by the caller afterwards, in index order, so the
+// result does not depend on how the chunks were scheduled.
+template <class Body>
+void parallel_ranges(WorkStealingPool* pool, size_t n, size_t chunk, const Body& body) {
+    size_t chunks = (n + chunk - 1) / chunk;
+    if (!pool || chunks <= 1) {
+        if (n > 0) body(size_t(0), n);
+        return;
+    }
+    pool->run(static_cast<int>(chunks), [&](int c) {
+        size_t begin = static_cast<size_t>(c) * chunk;
+        body(begin, std::min(n, begin + chunk));
+    });
+}
+
+#endif //parallel
@@ -0,0 +1,303 @@
+#include "profiler.h"
+
+const char* PHASE_NAMES[NUM_PHASES] = {
+    "human_move", "animal_move", "contact_detection", "infection_update", "scoring", "display", "trial"
+};
+
+const char* HARDWARE_EVENT_NAMES[NUM_HARDWARE_EVENTS] = {
+    "instructions", "cycles", "cache_misses", "branch_misses"
+};
+
+#ifdef PROFILE_PHASES
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Per-thread event cap; later events are counted but not kept
+const size_t MAX_TRACE_EVENTS_PER_THREAD = 1 << 20;
+
+struct TraceEvent {
+    Phase phase;
+    int64_t start_ns;
+    int64_t duration_ns;
+    HardwareSample hardware;
+};
+
+// Owned by the registry rather than the thread, so the data outlives worker threads
+struct ThreadProfile {
+    int thread_index = 0;
+    PhaseCounters counters;
+    std::vector<TraceEvent> events;
+    long dropped_events = 0;
+    int perf_group_fd = -1;  // leader of this thread's hardware counter group, -1 once the thread exited
+    bool hardware = false;   // events carry hardware counts
+};
+
+// The calling thread's counter group; closed when the thread exits, by which time its counts
+// are in its profile
+struct PerfGroup {
+    std::vector<int> fds;  // leader first
+    ThreadProfile* profile = nullptr;
+
+    ~PerfGroup() {
+        if (this->profile) this->profile->perf_group_fd = -1;
+#ifdef __linux__
+        for (int fd : this->fds) close(fd);
+#endif
+    }
+};
+
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<ThreadProfile>> registry;
+static const int64_t profile_epoch_ns = profiler_now_ns();
+static const char* trace_path = std::getenv("ZVSIM_TRACE");
+static const bool perf_requested = std::getenv("ZVSIM_PERF_COUNTERS") && std::strcmp(std::getenv("ZVSIM_PERF_COUNTERS"), "0") != 0;
+static std::atomic<bool> perf_failed(false);
+static std::atomic<bool> perf_multiplexed(false);  // some counts were scaled up from a partial run
+
+#ifdef __linux__
+static const uint64_t PERF_CONFIGS[NUM_HARDWARE_EVENTS] = {
+    PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+// One counter group per thread, so a single read() returns all events consistently. With more
+// groups than hardware counters the kernel time-slices them, so reads also return how long the
+// group was enabled and actually counting.
+static bool open_perf_group(std::vector<int>& group) {
+    int fds[NUM_HARDWARE_EVENTS];
+    for (int i = 0; i < NUM_HARDWARE_EVENTS; i++) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_CONFIGS[i];
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = i == 0;
+        attr.exclude_kernel = 1;  // allowed at perf_event_paranoid <= 2
+        attr.exclude_hv = 1;
+
+        int leader = i == 0 ? -1 : fds[0];
+        fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fds[i] < 0) {
+            int err = errno;
+            for (int j = 0; j < i; j++) close(fds[j]);
+            if (!perf_failed.exchange(true)) {
+                std::cerr << "Hardware counters unavailable (" << HARDWARE_EVENT_NAMES[i] << ": "
+                          << std::strerror(err) << "); reporting wall time only" << std::endl;
+            }
+            return false;
+        }
+    }
+    ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    group.assign(fds, fds + NUM_HARDWARE_EVENTS);
+    return true;
+}
+#else
+static bool open_perf_group(std::vector<int>&) {
+    if (!perf_failed.exchange(true)) {
+        std::cerr << "Hardware counters need Linux perf_event_open; reporting wall time only" << std::endl;
+    }
+    return false;
+}
+#endif
+
+static ThreadProfile& thread_profile() {
+    thread_local PerfGroup group;
+    thread_local ThreadProfile* profile = [] {
+        bool hardware = perf_requested && !perf_failed && open_perf_group(group.fds);
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(std::make_unique<ThreadProfile>());
+        ThreadProfile* p = registry.back().get();
+        p->thread_index = static_cast<int>(registry.size()) - 1;
+        p->perf_group_fd = hardware ? group.fds[0] : -1;
+        p->hardware = hardware;
+        group.profile = p;
+        return p;
+    }();
+    return *profile;
+}
+
+static bool read_group(int fd, HardwareSample& sample) {
+#ifdef __linux__
+    uint64_t buf[3 + NUM_HARDWARE_EVENTS];  // nr, time enabled, time running, values
+    if (fd >= 0 && read(fd, buf, sizeof(buf)) == static_cast<ssize_t>(sizeof(buf)) && buf[0] == NUM_HARDWARE_EVENTS) {
+        sample.time_enabled = buf[1];
+        sample.time_running = buf[2];
+        for (int i = 0; i < NUM_HARDWARE_EVENTS; i++) sample.values[i] = buf[3 + i];
+        return true;
+    }
+#endif
+    return false;
+}
+
+// Counts between two samples, scaled by the time enabled / time running over the same interval,
+// i.e. estimated as if the group had counted the whole time (what perf stat reports for
+// multiplexed events). Raw counts only grow, so the difference is taken before scaling.
+static HardwareSample scaled_delta(const HardwareSample& start, const HardwareSample& end) {
+    HardwareSample delta;
+    uint64_t enabled = end.time_enabled - start.time_enabled;
+    uint64_t running = end.time_running - start.time_running;
+    delta.time_enabled = enabled;
+    delta.time_running = running;
+    if (running < enabled && !perf_multiplexed.load(std::memory_order_relaxed)) {
+        perf_multiplexed.store(true, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < NUM_HARDWARE_EVENTS; i++) {
+        uint64_t raw = end.values[i] >= start.values[i] ? end.values[i] - start.values[i] : 0;
+        delta.values[i] = running == 0 ? 0
+            : running == enabled ? raw
+            : static_cast<uint64_t>(static_cast<double>(raw) * enabled / running);
+    }
+    return delta;
+}
+
+void read_hardware_counters(HardwareSample& sample) {
+    read_group(thread_profile().perf_group_fd, sample);
+}
+
+bool hardware_counters_available() {
+    return perf_requested && !perf_failed;
+}
+
+int64_t profiler_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void record_phase(Phase phase, int64_t start_ns, int64_t end_ns, const HardwareSample& start_sample) {
+    ThreadProfile& p = thread_profile();
+    int i = static_cast<int>(phase);
+    p.counters.calls[i]++;
+    p.counters.nanoseconds[i] += end_ns - start_ns;
+
+    HardwareSample delta;
+    HardwareSample end_sample;
+    if (read_group(p.perf_group_fd, end_sample)) {
+        delta = scaled_delta(start_sample, end_sample);
+        for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+            p.counters.hardware[i][e] += delta.values[e];
+        }
+    }
+
+    if (trace_path) {
+        if (p.events.size() < MAX_TRACE_EVENTS_PER_THREAD) {
+            p.events.push_back({phase, start_ns, end_ns - start_ns, delta});
+        } else {
+            p.dropped_events++;
+        }
+    }
+}
+
+PhaseCounters phase_counters() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    PhaseCounters total;
+    for (const auto& p : registry) {
+        for (int i = 0; i < NUM_PHASES; i++) {
+            total.calls[i] += p->counters.calls[i];
+            total.nanoseconds[i] += p->counters.nanoseconds[i];
+            for (int e = 0; e < NUM_HARDWARE_EVENTS; e++) {
+                total.hardware[i][e] += p->counters.hardware[i][e];
+            }
+        }
+    }
+    return total;
+}
+
+void print_phase_report() {
+    PhaseCounters c = phase_counters();
+    int64_t tick_ns = 0;
+    for (int i = 0; i < NUM_PHASES; i++) {
+        if (static_cast<Phase>(i) != Phase::TRIAL) tick_ns += c.nanoseconds[i];
+    }
+
+    std::streamsize precision = std::cout.precision();  // restored for the reports that follow
+    std::cout << "Phase timings (all threads):" << std::endl;
+    for (int i = 0; i < NUM_PHASES; i++) {
+        double ms = c.nanoseconds[i] / 1e6;
+        std::cout << "  " << std::left << std::setw(18) << PHASE_NAMES[i] << std::right
+                  << std::setw(10) << c.calls[i] << " calls " << std::fixed << std::setprecision(2)
+                  << std::setw(12) << ms << " ms";
+        // Shares are of the summed tick phases; a trial spans all of them
+        if (static_cast<Phase>(i) != Phase::TRIAL && tick_ns > 0) {
+            std::cout << " " << std::setw(6) << std::setprecision(1) << 100.0 * c.nanoseconds[i] / tick_ns << "%";
+        } else {
+            std::cout << std::setw(8) << "";
+        }
+        if (hardware_counters_available()) {
+            const uint64_t* hw = c.hardware[i];
+            double instructions = static_cast<double>(hw[static_cast<int>(HardwareEvent::INSTRUCTIONS)]);
+            double cycles = static_cast<double>(hw[static_cast<int>(HardwareEvent::CYCLES)]);
+            double per_kilo = instructions > 0 ? 1000.0 / instructions : 0.0;
+            std::cout << std::setprecision(2) << std::setw(10) << instructions / 1e6 << "M instr "
+                      << std::setw(10) << cycles / 1e6 << "M cyc  IPC " << std::setw(5)
+                      << (cycles > 0 ? instructions / cycles : 0.0) << "  cache-miss/ki " << std::setw(6)
+                      << hw[static_cast<int>(HardwareEvent::CACHE_MISSES)] * per_kilo << "  br-miss/ki " << std::setw(6)
+                      << hw[static_cast<int>(HardwareEvent::BRANCH_MISSES)] * per_kilo;
+        }
+        std::cout << std::defaultfloat << std::endl;
+    }
+    if (perf_multiplexed) {
+        std::cout << "  (hardware counters were multiplexed; counts are scaled estimates)" << std::endl;
+    }
+    std::cout.precision(precision);
+}
+
+void write_phase_trace() {
+    if (!trace_path) return;
+
+    std::ofstream out(trace_path);
+    if (!out) {
+        std::cerr << "Cannot write trace to " << trace_path << std::endl;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    long events = 0, dropped = 0;
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& p : registry) {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << p->thread_index
+            << ",\"args\":{\"name\":\"thread " << p->thread_index << "\"}}";
+        first = false;
+        for (const TraceEvent& e : p->events) {
+            // Trace timestamps are microseconds
+            out << ",\n{\"name\":\"" << PHASE_NAMES[static_cast<int>(e.phase)] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                << p->thread_index << std::fixed << std::setprecision(3)
+                << ",\"ts\":" << (e.start_ns - profile_epoch_ns) / 1e3 << ",\"dur\":" << e.duration_ns / 1e3
+                << std::defaultfloat;
+            if (p->hardware) {
+                out << ",\"args\":{";
+                for (int k = 0; k < NUM_HARDWARE_EVENTS; k++) {
+                    out << (k ? "," : "") << "\"" << HARDWARE_EVENT_NAMES[k] << "\":" << e.hardware.values[k];
+                }
+                out << "}";
+            }
+            out << "}";
+        }
+        events += static_cast<long>(p->events.size());
+        dropped += p->dropped_events;
+    }
+    out << "\n]}\n";
+
+    std::cout << "Wrote " << events << " trace events to " << trace_path;
+    if (dropped > 0) std::cout << " (" << dropped << " dropped)";
+    std::cout << std::endl;
+}
+
+#endif
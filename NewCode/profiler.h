@@ -0,0 +1,93 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+
+// Per-phase tick instrumentation. Build with -DPROFILE_PHASES to time each phase into
+// per-thread counters, and set ZVSIM_TRACE=<file.json> to also record a Chrome trace-event
+// timeline (one track per thread, so one per worker). Set ZVSIM_PERF_COUNTERS=1 to also
+// count hardware events per phase with Linux perf_event_open; if the kernel refuses
+// (perf_event_paranoid, containers, other platforms) only wall time is reported.
+// Without PROFILE_PHASES every hook here compiles to nothing.
+
+enum class Phase {
+    HUMAN_MOVE,
+    ANIMAL_MOVE,
+    CONTACT_DETECTION, // once per tick, from the animal index refresh to the end of the contact phase
+    INFECTION_UPDATE,
+    SCORING,           // secondary cases and p_zoonotic
+    DISPLAY,           // snapshot publish on the simulation thread, drawing on the main (or capture) thread
+    TRIAL              // one whole trial
+};
+const int NUM_PHASES = 7;
+extern const char* PHASE_NAMES[NUM_PHASES];
+
+// User-space hardware events counted for the calling thread
+enum class HardwareEvent {
+    INSTRUCTIONS,
+    CYCLES,
+    CACHE_MISSES,
+    BRANCH_MISSES
+};
+const int NUM_HARDWARE_EVENTS = 4;
+extern const char* HARDWARE_EVENT_NAMES[NUM_HARDWARE_EVENTS];
+
+// Raw group counts, with how long the group was enabled and actually counting; only deltas of
+// whole samples are scaled (see record_phase)
+struct HardwareSample {
+    uint64_t values[NUM_HARDWARE_EVENTS] = {};
+    uint64_t time_enabled = 0;
+    uint64_t time_running = 0;
+};
+
+struct PhaseCounters {
+    long calls[NUM_PHASES] = {};
+    int64_t nanoseconds[NUM_PHASES] = {};
+    uint64_t hardware[NUM_PHASES][NUM_HARDWARE_EVENTS] = {};
+};
+
+#ifdef PROFILE_PHASES
+
+int64_t profiler_now_ns();
+// Running hardware event counts of the calling thread (all zero when unavailable)
+void read_hardware_counters(HardwareSample& sample);
+void record_phase(Phase phase, int64_t start_ns, int64_t end_ns, const HardwareSample& start_sample);
+bool hardware_counters_available();
+
+// Counters summed over every thread so far
+PhaseCounters phase_counters();
+void print_phase_report();
+// Write the timeline to $ZVSIM_TRACE (no-op when unset); open in chrome://tracing or Perfetto
+void write_phase_trace();
+
+// Times the enclosing scope as one occurrence of a phase
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase phase) : phase(phase) {
+        read_hardware_counters(this->start_sample);
+        this->start = profiler_now_ns();
+    }
+    ~PhaseTimer() { record_phase(this->phase, this->start, profiler_now_ns(), this->start_sample); }
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+private:
+    Phase phase;
+    int64_t start;
+    HardwareSample start_sample;
+};
+
+#else
+
+inline PhaseCounters phase_counters() { return PhaseCounters(); }
+inline bool hardware_counters_available() { return false; }
+inline void print_phase_report() {}
+inline void write_phase_trace() {}
+
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase) {}
+};
+
+#endif
+
+#endif //profiler
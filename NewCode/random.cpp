@@ -0,0 +1,40 @@
+#include "random.h"
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+SimRandom::SimRandom(uint64_t seed, bool antithetic) : seed(seed), antithetic(antithetic) {}
+
+double SimRandom::uniform(int agent_id, int tick, RandomStream stream) const {
+    uint64_t h = splitmix64(this->seed ^ splitmix64(static_cast<uint32_t>(agent_id)));
+    h = splitmix64(h ^ (static_cast<uint64_t>(static_cast<uint32_t>(tick)) << 8 | static_cast<uint64_t>(stream)));
+    double u = static_cast<double>(h >> 11) * (1.0 / 9007199254740992.0);
+    if (this->antithetic) {
+        // 1 - u lies in (0, 1]; step back from 1 so integer draws stay in range
+        u = 1.0 - u;
+        if (u >= 1.0) u = 0.9999999999999999;
+    }
+    return u;
+}
+
+int SimRandom::uniform_int(int agent_id, int tick, RandomStream stream, int lo, int hi) const {
+    int span = hi - lo + 1;
+    int offset = static_cast<int>(this->uniform(agent_id, tick, stream) * span);
+    if (offset >= span) offset = span - 1;
+    return lo + offset;
+}
+
+uint64_t derive_seed(uint64_t base, uint64_t index) {
+    return splitmix64(splitmix64(base) + index);
+}
+
+SimRandom trial_random(uint64_t run_seed, int trial_index, bool antithetic_pairs) {
+    if (!antithetic_pairs) {
+        return SimRandom(derive_seed(run_seed, trial_index));
+    }
+    return SimRandom(derive_seed(run_seed, trial_index / 2), trial_index % 2 == 1);
+}
@@ -0,0 +1,42 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Independent draw slots per agent per tick
+enum class RandomStream {
+    MOTION_X = 0,
+    MOTION_Y = 1,
+    INFECTION = 2,
+    MOTION_TURN = 3,
+    MOTION_STEP = 4,
+    ANIMAL_MOTION_X = 5,
+    ANIMAL_MOTION_Y = 6,
+    ANIMAL_MOTION_TURN = 7,
+    ANIMAL_MOTION_STEP = 8
+};
+
+// Counter-based generator: every draw is a pure function of (seed, agent, tick, stream),
+// so the whole RNG state of a trial is its seed. Draws don't depend on update order,
+// and a simulation can be snapshotted or forked at any tick without saving a stream position.
+class SimRandom {
+public:
+    uint64_t seed;
+    bool antithetic;  // mirror every draw (u -> 1 - u), pairing this trial with the plain one of the same seed
+
+    explicit SimRandom(uint64_t seed = 0, bool antithetic = false);
+
+    // Uniform in [0, 1)
+    double uniform(int agent_id, int tick, RandomStream stream) const;
+    // Uniform integer in [lo, hi]
+    int uniform_int(int agent_id, int tick, RandomStream stream, int lo, int hi) const;
+};
+
+// Seed for the index-th child of base (trials, forks, shards)
+uint64_t derive_seed(uint64_t base, uint64_t index);
+
+// Generator for trial trial_index of a run. With antithetic_pairs, trials 2k and 2k+1
+// share a seed and the odd one is mirrored.
+SimRandom trial_random(uint64_t run_seed, int trial_index, bool antithetic_pairs);
+
+#endif //random
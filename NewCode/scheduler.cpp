@@ -0,0 +1,156 @@
+#include "scheduler.h"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+double WorkerStats::utilization() const {
+    if (this->wall_seconds <= 0.0) return 0.0;
+    return this->busy_seconds / this->wall_seconds;
+}
+
+WorkStealingPool::WorkStealingPool(int num_workers)
+    : workers(num_workers > 0 ? num_workers : 1),
+      worker_stats(workers.size()),
+      current_task(nullptr),
+      generation(0),
+      shutting_down(false),
+      active_workers(0) {
+    for (int w = 0; w < static_cast<int>(this->workers.size()); ++w) {
+        this->threads.emplace_back(&WorkStealingPool::worker_loop, this, w);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> guard(this->run_lock);
+        this->shutting_down = true;
+    }
+    this->run_changed.notify_all();
+    for (auto& t : this->threads) t.join();
+}
+
+int WorkStealingPool::size() const {
+    return static_cast<int>(this->workers.size());
+}
+
+const std::vector<WorkerStats>& WorkStealingPool::stats() const {
+    return this->worker_stats;
+}
+
+void WorkStealingPool::run(int count, const std::function<void(int)>& task) {
+    if (count <= 0) return;
+
+    // Contiguous blocks per worker; stealing rebalances whatever this gets wrong
+    int n = this->size();
+    for (int w = 0; w < n; ++w) {
+        std::lock_guard<std::mutex> guard(this->workers[w].lock);
+        int begin = static_cast<int>(static_cast<long>(count) * w / n);
+        int end = static_cast<int>(static_cast<long>(count) * (w + 1) / n);
+        for (int i = begin; i < end; ++i) {
+            this->workers[w].tasks.push_back(i);
+        }
+    }
+
+    Clock::time_point run_start = Clock::now();
+    std::unique_lock<std::mutex> guard(this->run_lock);
+    this->current_task = &task;
+    this->first_error = nullptr;
+    this->active_workers = n;
+    this->generation++;
+    this->run_changed.notify_all();
+    this->run_changed.wait(guard, [this] { return this->active_workers == 0; });
+    this->current_task = nullptr;
+
+    // Every worker is charged the whole run, so time idling at the tail shows up as lost utilization
+    double wall = seconds_since(run_start);
+    for (auto& stats : this->worker_stats) {
+        stats.wall_seconds += wall;
+    }
+
+    if (this->first_error) {
+        std::rethrow_exception(this->first_error);
+    }
+}
+
+bool WorkStealingPool::pop_local(int worker, int& task) {
+    Worker& w = this->workers[worker];
+    std::lock_guard<std::mutex> guard(w.lock);
+    if (w.tasks.empty()) return false;
+    task = w.tasks.back();
+    w.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(int thief, int& task) {
+    int n = this->size();
+    for (int offset = 1; offset < n; ++offset) {
+        Worker& victim = this->workers[(thief + offset) % n];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::worker_loop(int worker) {
+    long seen_generation = 0;
+    while (true) {
+        const std::function<void(int)>* task_fn = nullptr;
+        {
+            std::unique_lock<std::mutex> guard(this->run_lock);
+            this->run_changed.wait(guard, [&] { return this->shutting_down || this->generation != seen_generation; });
+            if (this->shutting_down) return;
+            seen_generation = this->generation;
+            task_fn = this->current_task;
+        }
+
+        WorkerStats& stats = this->worker_stats[worker];
+        int task = 0;
+        while (true) {
+            bool stolen = false;
+            if (!this->pop_local(worker, task)) {
+                if (!this->steal(worker, task)) break;
+                stolen = true;
+            }
+
+            Clock::time_point task_start = Clock::now();
+            try {
+                (*task_fn)(task);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(this->run_lock);
+                if (!this->first_error) this->first_error = std::current_exception();
+            }
+            stats.busy_seconds += seconds_since(task_start);
+            stats.tasks++;
+            if (stolen) stats.steals++;
+        }
+
+        std::lock_guard<std::mutex> guard(this->run_lock);
+        if (--this->active_workers == 0) {
+            this->run_changed.notify_all();
+        }
+    }
+}
+
+void WorkStealingPool::print_stats() const {
+    // Restored at the end: later reports print with the stream's default precision
+    std::streamsize precision = std::cout.precision();
+    std::cout << "Worker utilization:" << std::endl;
+    for (size_t w = 0; w < this->worker_stats.size(); ++w) {
+        const WorkerStats& stats = this->worker_stats[w];
+        std::cout << "  worker " << w << ": " << stats.tasks << " tasks, " << stats.steals << " stolen, busy "
+                  << std::fixed << std::setprecision(3) << stats.busy_seconds << "s / " << stats.wall_seconds << "s ("
+                  << std::setprecision(1) << 100.0 * stats.utilization() << "%)" << std::defaultfloat << std::endl;
+    }
+    std::cout.precision(precision);
+}
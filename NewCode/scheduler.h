@@ -0,0 +1,64 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Per-worker accounting, accumulated over every run() of the pool
+struct WorkerStats {
+    long tasks = 0;            // tasks executed
+    long steals = 0;           // tasks taken from another worker's deque
+    double busy_seconds = 0;   // time spent inside tasks
+    double wall_seconds = 0;   // time the pool was running work
+
+    double utilization() const;
+};
+
+// Fixed set of worker threads, each with its own task deque. Workers pop their own deque
+// from the back and, when it runs dry, steal from the front of a victim's deque, so a few
+// expensive tasks (long sicknesses, large populations) don't leave the other cores idle.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int num_workers);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Run task(i) for every i in [0, count) and wait for all of them. The first exception
+    // thrown by a task is rethrown here once the run has drained.
+    void run(int count, const std::function<void(int)>& task);
+
+    int size() const;
+    const std::vector<WorkerStats>& stats() const;
+    void print_stats() const;
+
+private:
+    struct Worker {
+        std::mutex lock;
+        std::deque<int> tasks;
+    };
+
+    std::vector<Worker> workers;
+    std::vector<WorkerStats> worker_stats;
+    std::vector<std::thread> threads;
+
+    std::mutex run_lock;
+    std::condition_variable run_changed;
+    const std::function<void(int)>* current_task;
+    long generation;
+    bool shutting_down;
+    int active_workers;
+    std::exception_ptr first_error;
+
+    bool pop_local(int worker, int& task);
+    bool steal(int thief, int& task);
+    void worker_loop(int worker);
+};
+
+#endif //scheduler
@@ -0,0 +1,154 @@
+#include "shard.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <csignal>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static const char* SHARD_MAGIC = "zvsim-shard";
+static const int SHARD_VERSION = 2;  // 2: per-trial contact graph summary
+
+bool write_shard_results(const std::string& path, int first_trial, const std::vector<TrialResult>& results) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    // 17 significant digits round-trip every double exactly
+    out.precision(std::numeric_limits<double>::max_digits10);
+    out << SHARD_MAGIC << " " << SHARD_VERSION << "\n";
+    out << "trials " << first_trial << " " << results.size() << "\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const TrialResult& r = results[i];
+        out << "trial " << (first_trial + static_cast<int>(i)) << " " << r.weight << " " << r.humans.size() << "\n";
+        for (size_t k = 0; k < r.humans.size(); ++k) {
+            const SimulationHumanResult& h = r.humans[k];
+            out << (*r.ids)[k] << " " << h.sickness_secondary_cases << " " << h.sickness_animal_hazard << " "
+                << h.sickness_human_hazard << " " << h.sickness_p_zoonotic << "\n";
+        }
+        const ContactGraphSummary& g = r.contact_graph;
+        out << "graph " << g.recorded;
+        if (g.recorded) {
+            out << " " << g.edges << " " << g.mean_degree << " " << g.max_degree << " " << g.chains << " "
+                << g.longest_chain << " " << g.mean_attributed_infections;
+        }
+        out << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+bool read_shard_results(const std::string& path, int& first_trial, std::vector<TrialResult>& results) {
+    std::ifstream in(path);
+    std::string magic, tag;
+    int version = 0;
+    size_t count = 0;
+    if (!(in >> magic >> version) || magic != SHARD_MAGIC || version != SHARD_VERSION) return false;
+    if (!(in >> tag >> first_trial >> count) || tag != "trials") return false;
+
+    results.clear();
+    results.reserve(count);
+    std::vector<int> ids;
+    std::shared_ptr<const std::vector<int>> shared_ids;  // one copy while the population stays the same
+    for (size_t i = 0; i < count; ++i) {
+        int index = 0;
+        size_t num_humans = 0;
+        TrialResult r;
+        if (!(in >> tag >> index >> r.weight >> num_humans) || tag != "trial" || index != first_trial + static_cast<int>(i)) {
+            return false;
+        }
+        ids.clear();
+        for (size_t k = 0; k < num_humans; ++k) {
+            int id = 0;
+            SimulationHumanResult h;
+            if (!(in >> id >> h.sickness_secondary_cases >> h.sickness_animal_hazard
+                     >> h.sickness_human_hazard >> h.sickness_p_zoonotic)) {
+                return false;
+            }
+            ids.push_back(id);
+            r.humans.push_back(h);
+        }
+        ContactGraphSummary& g = r.contact_graph;
+        if (!(in >> tag >> g.recorded) || tag != "graph") return false;
+        if (g.recorded && !(in >> g.edges >> g.mean_degree >> g.max_degree >> g.chains
+                               >> g.longest_chain >> g.mean_attributed_infections)) {
+            return false;
+        }
+        if (!shared_ids || *shared_ids != ids) {
+            shared_ids = std::make_shared<const std::vector<int>>(ids);
+        }
+        r.ids = shared_ids;
+        results.push_back(r);
+    }
+    return true;
+}
+
+bool run_sharded(const std::string& exe, int num_shards, uint64_t run_seed,
+                 const std::string& shard_dir, std::vector<TrialResult>& results) {
+    fs::create_directories(shard_dir);
+
+    std::vector<pid_t> children;
+    std::vector<std::string> paths;
+    for (int k = 0; k < num_shards; ++k) {
+        std::string path = shard_dir + "/shard_" + std::to_string(k) + ".txt";
+        std::string log_path = shard_dir + "/shard_" + std::to_string(k) + ".log";
+        paths.push_back(path);
+
+        std::vector<std::string> args = {
+            exe, "--shard", std::to_string(k), "--of", std::to_string(num_shards),
+            "--out", path, "--seed", std::to_string(run_seed)
+        };
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "fork failed for shard " << k << std::endl;
+            // Don't leave the shards already started running (or as zombies)
+            for (pid_t child : children) {
+                kill(child, SIGTERM);
+                waitpid(child, nullptr, 0);
+            }
+            return false;
+        }
+        if (pid == 0) {
+            // Child: keep the driver's console readable
+            if (!freopen(log_path.c_str(), "w", stdout)) _exit(127);
+            std::vector<char*> argv;
+            for (auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+            argv.push_back(nullptr);
+            // Re-run this binary: argv[0] is not a usable path when it was started through PATH.
+            // /proc/self/exe is exact on Linux; elsewhere fall back to a PATH search.
+            execv("/proc/self/exe", argv.data());
+            execvp(exe.c_str(), argv.data());
+            _exit(127);
+        }
+        children.push_back(pid);
+    }
+
+    bool ok = true;
+    for (int k = 0; k < num_shards; ++k) {
+        int status = 0;
+        waitpid(children[k], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "Shard " << k << " failed (see " << shard_dir << "/shard_" << k << ".log)" << std::endl;
+            ok = false;
+        }
+    }
+    if (!ok) return false;
+
+    // Merge in trial order
+    results.clear();
+    for (int k = 0; k < num_shards; ++k) {
+        int first_trial = 0;
+        std::vector<TrialResult> part;
+        if (!read_shard_results(paths[k], first_trial, part) || first_trial != static_cast<int>(results.size())) {
+            std::cerr << "Invalid or out-of-order shard file: " << paths[k] << std::endl;
+            return false;
+        }
+        results.insert(results.end(), part.begin(), part.end());
+    }
+    std::cout << "Merged " << num_shards << " shards: " << results.size() << " trials" << std::endl;
+    return true;
+}
@@ -0,0 +1,22 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "simulator.h"
+
+// Partial results of one shard: the raw per-trial results of a contiguous trial range
+// (per-human results and the contact graph summary), written at full precision. Merging shards concatenates trial ranges, so counts, moments
+// and quantiles of the merged run are exactly those of a single-process run.
+bool write_shard_results(const std::string& path, int first_trial, const std::vector<TrialResult>& results);
+bool read_shard_results(const std::string& path, int& first_trial, std::vector<TrialResult>& results);
+
+// Driver: fork and re-exec this binary once per shard (--shard k --of K --out ... --seed ...),
+// wait for all of them, then merge the partial files in trial order into results. exe is the
+// program's argv[0], only searched on PATH where /proc/self/exe is unavailable. Local
+// processes only.
+bool run_sharded(const std::string& exe, int num_shards, uint64_t run_seed,
+                 const std::string& shard_dir, std::vector<TrialResult>& results);
+
+#endif //shard
@@ -3,6 +3,13 @@
 #include "agents.h"
 #include "data.h"
 #include "display.h"
+#include "checkpoint.h"
+#include "stats.h"
+#include "adaptive.h"
+#include "shard.h"
+#include "alloc_tracking.h"
+#include "engine.h"
+#include "profiler.h"
 
 #include <iostream>
 #include <cmath>
@@ -14,48 +21,118 @@ namespace fs = std::filesystem;
 #include <random>
 #include <numeric>
 #include <algorithm>
+#include <functional>
+#include <memory>
 
 using namespace std;
 
 const bool USE_DISPLAY = true;  
+const WorldView WORLD_VIEW = {0.0f, 0.0f, GRID_WIDTH, GRID_HEIGHT};  // model coordinates shown in the window
+const bool HEADLESS_CAPTURE = false;  // record frames offscreen instead of opening a window
+// Without -DCAPTURE_ZLIB each PNG is stored uncompressed, as large as a raw frame
+// (GRID_WIDTH * GRID_HEIGHT * 3 bytes per tick), so long captures fill the disk quickly
+const CaptureFormat CAPTURE_FORMAT = CaptureFormat::PNG_SEQUENCE;
 const bool SAVE_DATA = true;
 const int NUM_TRIALS = 1000;
+const uint64_t BASE_SEED = 1;
+// Variance reduction. Antithetic pairs mirror every motion-noise and infection draw of the
+// previous trial. Common random numbers reuse the same per-trial streams in every run, so runs
+// that differ only in parameters (dataset, hazards, motion model) are paired trial by trial;
+// turning it off draws a fresh stream from the run timestamp.
+const bool ANTITHETIC_PAIRS = false;
+const bool COMMON_RANDOM_NUMBERS = true;
+// Trials actually run: pairs are never split, so an odd NUM_TRIALS gets one more with antithetic pairs
+const int TOTAL_TRIALS = ANTITHETIC_PAIRS ? (NUM_TRIALS + 1) / 2 * 2 : NUM_TRIALS;
+// Adaptive stopping: run trials in batches until every confidence interval is tight enough
+// (NUM_TRIALS is then only the upper bound)
+const bool ADAPTIVE_STOPPING = false;
+const StoppingRule STOPPING_RULE = {
+    {0.05, 0.05, 0.05, 0.02},  // CI half-width tolerance per metric (see METRIC_NAMES)
+    1.96,                      // z for 95% confidence
+    50,                        // batch size
+    100,                       // min trials
+    TOTAL_TRIALS               // max trials
+};
+const bool FORK_SHARED_PREFIX = true;  // simulate the deterministic prefix once, fork the trials from it
+const int NUM_WORKERS = 0;  // trial worker threads when running without a display (0 = one per core)
 const long GLOBAL_DESC = time(nullptr);
-const string MOTION_MODEL_DESC = "h_noisy_interp";
+const string MOTION_MODEL_DESC = "h_noisy_interp";        // h_noisy_interp, h_gauss_interp, h_crw, h_levy
+const string ANIMAL_MOTION_MODEL_DESC = "a_path";         // a_path, a_home_range, a_random_walk
+const string ANIMAL_CONTACT_INDEX = "raster";             // raster (few, static animals) or bvh (many, moving, overlapping)
+const bool LONG_HORIZON = false;  // bounded-memory runs: keep only history that can still affect results
+const int TICK_WORKERS = 0;  // >1 splits each tick's human update across threads (one trial at a time); 0 = serial
+const float DOMAIN_TILE_SIZE = 0.0f;  // >0 cuts the plane into tiles this wide (model units), each updated as one task
+const bool RECORD_CONTACT_GRAPH = false;  // build a contact graph per trial and report degree and transmission chain stats
 const string DATASET_DESC = "RD";
 
 int seconds_to_sim_ticks(double s) {
     return static_cast<int>(s / SIM_TICK_TIME_SECONDS);
 }
 
-Simulation::Simulation() : time_step(0) {}
+const char* METRIC_NAMES[NUM_METRICS] = {
+    "Secondary Cases",
+    "Animal Hazard @ Sickness",
+    "Human Hazard @ Sickness",
+    "P(Sickness from Zoonotic Origin)"
+};
+
+double metric_value(const SimulationHumanResult& r, Metric m) {
+    switch (m) {
+        case Metric::SECONDARY_CASES: return r.sickness_secondary_cases;
+        case Metric::ANIMAL_HAZARD:   return r.sickness_animal_hazard;
+        case Metric::HUMAN_HAZARD:    return r.sickness_human_hazard;
+        case Metric::P_ZOONOTIC:      return r.sickness_p_zoonotic;
+    }
+    return 0.0;
+}
 
-void Simulation::add_agent(void* agent) {
-    Human* h = dynamic_cast<Human*>((Human*)agent);
-    if (h)
-        human_agents[h->id] = h;
-    else
-        animal_agents.push_back((AnimalPresence*)agent);
+// Shared by every Simulation; run_trials runs trials one at a time when it exists
+static WorkStealingPool* shared_tick_pool() {
+    if (TICK_WORKERS <= 1) return nullptr;
+    static WorkStealingPool pool(TICK_WORKERS);
+    return &pool;
 }
 
-void Simulation::update() {
-    for (auto& [id, h] : human_agents) h->move(this);
-    for (auto* a : animal_agents) a->move(this);
+Simulation::Simulation(uint64_t seed)
+    : time_step(0), rng(seed), log_likelihood_ratio(0.0), long_horizon(LONG_HORIZON),
+      record_contacts(RECORD_CONTACT_GRAPH),
+      engine(find_engine(MOTION_MODEL_DESC, ANIMAL_MOTION_MODEL_DESC, ANIMAL_CONTACT_INDEX, user::SIMULATE_SPREAD)),
+      tick_pool(shared_tick_pool()),
+      humans_indexed(false),
+      domain(DOMAIN_TILE_SIZE > 0.0f ? make_unique<DomainDecomposition>(DOMAIN_TILE_SIZE) : nullptr) {}
 
-    for (auto& [id, h] : human_agents) h->update(this);
-    for (auto* a : animal_agents) a->update(this);
+void Simulation::clear_agents() {
+    human_agents.clear();
+    animal_agents.clear();
+    // The dense index pointed into the agents just destroyed
+    human_order.clear();
+    human_ids.reset();
+    humans_indexed = false;
+}
+
+void Simulation::add_agent(unique_ptr<Human> human) {
+    int id = human->id;
+    human_agents[id] = std::move(human);
+    humans_indexed = false;
+}
 
-    time_step++;
+void Simulation::add_agent(unique_ptr<AnimalPresence> animal) {
+    animal_agents.push_back(std::move(animal));
+}
+
+// One indirect call per tick; everything inside the selected engine is statically dispatched
+void Simulation::update() {
+    engine.tick(*this);
 }
 
 void Simulation::print_results() const {
     for (const auto& [id, h] : human_agents) {
         cout << "*** HUMAN " << id << " ***\n";
-        cout << "Final infection model: " << h->infection_model << "\n";
+        cout << "Final infection model: " << h->infection_model.__str__() << "\n";
         
         cout << "Contact network:\n";
         for (const auto& [time, contact] : h->contact_network) {
-            cout << "  Time " << time << ": " << contact.__repr__() << "\n";
+            cout << "  Time " << time << " with HUMAN " << human_order[contact.other]->id << ": " << contact.__repr__() << "\n";
         }
         
         cout << "Sickness records:\n";
@@ -67,22 +144,36 @@ void Simulation::print_results() const {
     }
 }
 
-map<int, SimulationHumanResult> Simulation::get_results() const {
-    map<int, SimulationHumanResult> res;
+TrialResult Simulation::get_results() const {
+    TrialResult res;
+    res.weight = exp(log_likelihood_ratio);
+    if (humans_indexed) {
+        res.ids = human_ids;
+    } else {
+        auto ids = make_shared<vector<int>>();
+        for (const auto& [id, h] : human_agents) ids->push_back(id);
+        res.ids = std::move(ids);
+    }
 
+    // human_agents is in id order, so this is dense index order
+    res.humans.reserve(human_agents.size());
     for (const auto& [id, h] : human_agents) {
         SimulationHumanResult r;
+        r.sickness_secondary_cases = h->evicted_secondary_cases;
 
         for (const auto& s : h->sickness_records) {
             r.sickness_secondary_cases += s.secondary_cases;
-            r.sickness_animal_hazard = s.start_infection_model->experienced_animal_hazard;
-            r.sickness_human_hazard = s.start_infection_model->experienced_human_hazard;
+            r.sickness_animal_hazard = s.start_infection_model.experienced_animal_hazard;
+            r.sickness_human_hazard = s.start_infection_model.experienced_human_hazard;
             r.sickness_p_zoonotic = s.p_zoonotic;
         }
 
-        res[id] = r;
+        res.humans.push_back(r);
     }
 
+    if (record_contacts) {
+        res.contact_graph = summarize_contact_graph(build_contact_graph(*this));
+    }
     return res;
 }
 
@@ -90,68 +181,86 @@ double Simulation::get_current_real_time() const {
     return time_step * SIM_TICK_TIME_SECONDS;
 }
 
-map<int, SimulationHumanResult> trial() {
-    Simulation sim;
-    
+void load_dataset(Simulation& sim) {
     // Initialize datasets if needed
     if (RD_HUMANS.empty() || RD_ANIMALS.empty()) {
         init_datasets();  
     }
-    
-    Display* display = nullptr;
-    if (USE_DISPLAY) {
-        display = new Display(&sim, GRID_WIDTH, GRID_HEIGHT);
-    }
-    
+
     // IMPORTANT: Create COPIES of agents for this trial
     // Otherwise all trials share the same agent instances
-    vector<AnimalPresence*> animals;
-    vector<Human*> humans;
-    
-    // Deep copy animals from RD_ANIMALS
     for (auto* orig : RD_ANIMALS) {
-        animals.push_back(new AnimalPresence(*orig));
+        sim.add_agent(make_unique<AnimalPresence>(*orig));
     }
     
-    // Deep copy humans from RD_HUMANS  
     for (auto* orig : RD_HUMANS) {
-        humans.push_back(new Human(*orig));
-    }
-    
-    // Add to simulation
-    for (auto* a : animals) {
-        sim.animal_agents.push_back(a);
+        sim.add_agent(make_unique<Human>(*orig));
     }
-    
-    for (auto* h : humans) {
-        sim.human_agents[h->id] = h;
-    }
-    
+}
+
+void run_to_end(Simulation& sim, Display* display) {
     bool running = true;
     while (running) {
         sim.update();
         
         if (USE_DISPLAY && display) {
-            running = display->render();
+            // Hand the tick to the viewer; it draws at its own frame rate
+            PhaseTimer timer(Phase::DISPLAY);
+            display->publish();
+            running = display->is_open();
         }
         
         if (sim.time_step > seconds_to_sim_ticks(STOP_SIM_AFTER))
             running = false;
     }
+}
+
+// The dataset at tick 0, which trial() resets its simulation to
+static const SimulationSnapshot& dataset_scenario() {
+    static const SimulationSnapshot scenario = [] {
+        Simulation sim;
+        load_dataset(sim);
+        return sim.snapshot();
+    }();
+    return scenario;
+}
+
+TrialResult trial(const SimRandom& rng) {
+    PhaseTimer timer(Phase::TRIAL);
+    // Trials run one at a time here, so one simulation is reset in place for all of them
+    static Simulation sim;
+    sim.restore(dataset_scenario());
+    sim.rng = rng;
     
-    if (USE_DISPLAY && display) {
-        display->cleanup();
+    // Set once a display fails to open, so later trials neither retry it nor log it again
+    static bool display_unavailable = false;
+    bool show = USE_DISPLAY && !display_unavailable;
+    Display* display = nullptr;
+    if (show && HEADLESS_CAPTURE) {
+        static int captured_trials = 0;
+        string capture_dir = "data/" + DATASET_DESC + "/" + MOTION_MODEL_DESC + "/frames_"
+            + to_string(GLOBAL_DESC) + "/trial_" + to_string(captured_trials++);
+        display = new Display(&sim, GRID_WIDTH, GRID_HEIGHT, WORLD_VIEW, capture_dir, CAPTURE_FORMAT);
+    } else if (show) {
+        display = new Display(&sim, GRID_WIDTH, GRID_HEIGHT, WORLD_VIEW);
+    }
+    if (display && !display->is_open()) {
+        // The window (or capture framebuffer) failed to open: run this and later trials without it
+        cerr << "Display unavailable, running trials without it" << endl;
+        display_unavailable = true;
         delete display;
+        display = nullptr;
     }
     
-    // Get results BEFORE cleaning up agents
-    auto results = sim.get_results();
-    
-    // Clean up trial-specific agents
-    for (auto* a : animals) delete a;
-    for (auto* h : humans) delete h;
+    if (display) {
+        display->run([display] { run_to_end(sim, display); });
+        display->cleanup();
+        delete display;
+    } else {
+        run_to_end(sim, nullptr);
+    }
     
-    return results;
+    return sim.get_results();
 }
 
 // Calculate statistics for boxplot
@@ -238,7 +347,8 @@ void save_data_and_plot(const vector<vector<double>>& data, const string& value)
         py_out << "    plt.boxplot(data.T)\n";
         py_out << "    plt.xlabel('Human Agent ID')\n";
         py_out << "    plt.ylabel('" << value << "')\n";
-        py_out << "    plt.title('" << value << " by ID (n=" << NUM_TRIALS << " trials)')\n";
+        size_t num_trials = data.empty() ? 0 : data[0].size();
+        py_out << "    plt.title('" << value << " by ID (n=" << num_trials << " trials)')\n";
         py_out << "    \n";
         py_out << "    num_humans = data.shape[0]\n";
         py_out << "    plt.xticks(range(1, num_humans + 1), range(num_humans))\n";
@@ -285,26 +395,64 @@ void save_data_and_plot(const vector<vector<double>>& data, const string& value)
 }
 
 #ifdef BUILD_SIM_MAIN
-int main() {
-    cout << "**ZV-Sim**" << endl;
-    cout << "Running " << NUM_TRIALS << " trials..." << endl;
-
-    vector<map<int, SimulationHumanResult>> all_results;
+// Run trials [first, first + count), or adaptively from first when adaptive is set
+static vector<TrialResult> run_trials(uint64_t run_seed, int first, int count, bool adaptive) {
+    vector<TrialResult> all_results;
+    std::function<vector<TrialResult>(int, int)> run_batch;
+    SimulationSnapshot prefix_snapshot;
+    unique_ptr<WorkStealingPool> pool;
+    SimulationCache simulations;  // reset between trials and batches instead of rebuilt
     
-    // Run all trials
-    for (int i = 0; i < NUM_TRIALS; ++i) {
-        if ((i + 1) % 100 == 0) {
-            cout << "Progress: " << (i + 1) << "/" << NUM_TRIALS << endl;
+    if (FORK_SHARED_PREFIX && !USE_DISPLAY) {
+        // Every trial starts with the same draw-free ticks: run them once and fork.
+        // Child i gets the same seed trial i would have, so results are identical.
+        Simulation prefix(run_seed);
+        load_dataset(prefix);
+        int prefix_ticks = deterministic_prefix_ticks(prefix);
+        while (prefix.time_step < prefix_ticks) {
+            prefix.update();
         }
-        try {
-            all_results.push_back(trial());
-        } catch (const exception& e) {
-            cerr << "Error in trial " << i << ": " << e.what() << endl;
-            return 1;
+        cout << "Shared deterministic prefix: " << prefix_ticks << " ticks" << endl;
+        prefix_snapshot = prefix.snapshot();
+        int workers = NUM_WORKERS > 0 ? NUM_WORKERS : static_cast<int>(thread::hardware_concurrency());
+        if (TICK_WORKERS <= 1) {
+            pool = make_unique<WorkStealingPool>(workers);  // otherwise the cores are busy inside each trial
         }
-        this_thread::sleep_for(chrono::milliseconds(1));
+        run_batch = [&](int first, int count) {
+            return fork_trials(prefix_snapshot, first, count, run_seed, ANTITHETIC_PAIRS, pool.get(), &simulations);
+        };
+    } else {
+        run_batch = [&](int first, int count) {
+            vector<TrialResult> batch;
+            for (int i = first; i < first + count; ++i) {
+                if ((i + 1) % 100 == 0) {
+                    cout << "Progress: " << (i + 1) << "/" << TOTAL_TRIALS << endl;
+                }
+                batch.push_back(trial(trial_random(run_seed, i, ANTITHETIC_PAIRS)));
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            return batch;
+        };
+    }
+
+    if (adaptive) {
+        AdaptiveRunController controller(STOPPING_RULE, ANTITHETIC_PAIRS);
+        all_results = controller.run(run_batch);
+        controller.print_report();
+    } else {
+        all_results = run_batch(first, count);
     }
+    if (pool) {
+        pool->print_stats();
+    }
+    print_allocation_report();
+    print_phase_report();
+    write_phase_trace();
+    return all_results;
+}
 
+// Aggregate, summarize and save a complete run (single process or merged shards)
+static int report_results(const vector<TrialResult>& all_results) {
     cout << "Simulation complete: " << all_results.size() << " trials." << endl;
     
     // Check if we have results
@@ -313,27 +461,39 @@ int main() {
         return 1;
     }
     
-    // Determine number of humans (from first trial)
+    // Determine number of humans (from first trial); rows are external ids
     int num_humans = 0;
     if (!all_results.empty()) {
-        for (const auto& [id, _] : all_results[0]) {
+        for (int id : *all_results[0].ids) {
             num_humans = max(num_humans, id + 1);
         }
     }
     
     cout << "Number of humans: " << num_humans << endl;
     
-    // Initialize data matrices: [num_humans][NUM_TRIALS]
-    vector<vector<double>> secondary_cases(num_humans, vector<double>(NUM_TRIALS, 0.0));
-    vector<vector<double>> animal_hazard(num_humans, vector<double>(NUM_TRIALS, 0.0));
-    vector<vector<double>> human_hazard(num_humans, vector<double>(NUM_TRIALS, 0.0));
-    vector<vector<double>> p_zoonotic(num_humans, vector<double>(NUM_TRIALS, 0.0));
+    // Initialize data matrices: [num_humans][num_trials]
+    int num_trials = static_cast<int>(all_results.size());
+    vector<double> weights;
+    bool weighted = false;
+    for (const auto& run : all_results) {
+        weights.push_back(run.weight);
+        weighted = weighted || run.weight != 1.0;
+    }
+    if (!weighted) {
+        weights.clear();
+    }
+    vector<vector<double>> secondary_cases(num_humans, vector<double>(num_trials, 0.0));
+    vector<vector<double>> animal_hazard(num_humans, vector<double>(num_trials, 0.0));
+    vector<vector<double>> human_hazard(num_humans, vector<double>(num_trials, 0.0));
+    vector<vector<double>> p_zoonotic(num_humans, vector<double>(num_trials, 0.0));
     
     // Aggregate results
-    for (int trial_num = 0; trial_num < NUM_TRIALS; ++trial_num) {
+    for (int trial_num = 0; trial_num < num_trials; ++trial_num) {
         const auto& run = all_results[trial_num];
         
-        for (const auto& [id, human_res] : run) {
+        for (size_t i = 0; i < run.humans.size(); ++i) {
+            int id = (*run.ids)[i];
+            const SimulationHumanResult& human_res = run.humans[i];
             secondary_cases[id][trial_num] = human_res.sickness_secondary_cases;
             animal_hazard[id][trial_num] = human_res.sickness_animal_hazard;
             human_hazard[id][trial_num] = human_res.sickness_human_hazard;
@@ -341,6 +501,53 @@ int main() {
         }
     }
     
+    // Monte Carlo precision per metric and human
+    cout << "\nEstimates (mean +/- std. error, effective sample size"
+         << (ANTITHETIC_PAIRS ? ", antithetic pairs" : "") << (weighted ? ", importance weighted" : "") << "):" << endl;
+    if (weighted) {
+        cout << "  Importance weights: Kish ESS " << static_cast<long>(weight_effective_sample_size(weights))
+             << " of " << num_trials << " trials" << endl;
+    }
+    vector<pair<string, const vector<vector<double>>*>> metrics = {
+        {"Secondary Cases", &secondary_cases},
+        {"Animal Hazard @ Sickness", &animal_hazard},
+        {"Human Hazard @ Sickness", &human_hazard},
+        {"P(Sickness from Zoonotic Origin)", &p_zoonotic},
+    };
+    for (const auto& [name, rows] : metrics) {
+        for (int id = 0; id < num_humans; ++id) {
+            MetricSummary m = summarize_metric((*rows)[id], weights, ANTITHETIC_PAIRS);
+            cout << "  " << name << " [human " << id << "]: " << m.mean << " +/- ";
+            if (m.has_standard_error) {
+                cout << m.standard_error;
+            } else {
+                cout << "n/a";
+            }
+            cout << " (ESS " << static_cast<long>(m.effective_sample_size) << ")" << endl;
+        }
+    }
+
+    // Contact graph analytics, averaged over trials (unweighted)
+    bool graphs = all_of(all_results.begin(), all_results.end(),
+                         [](const TrialResult& r) { return r.contact_graph.recorded; });
+    if (graphs) {
+        double edges = 0.0, mean_degree = 0.0, max_degree = 0.0, chains = 0.0, longest = 0.0, attributed = 0.0;
+        for (const auto& run : all_results) {
+            const ContactGraphSummary& g = run.contact_graph;
+            edges += g.edges;
+            mean_degree += g.mean_degree;
+            max_degree += g.max_degree;
+            chains += g.chains;
+            longest += g.longest_chain;
+            attributed += g.mean_attributed_infections;
+        }
+        cout << "\nContact graph (mean per trial):" << endl;
+        cout << "  Contacts: " << edges / num_trials << ", degree " << mean_degree / num_trials
+             << " (max " << max_degree / num_trials << ")" << endl;
+        cout << "  Transmission chains: " << chains / num_trials << ", longest " << longest / num_trials
+             << " generations, " << attributed / num_trials << " attributed infections per sickness" << endl;
+    }
+    
     // Save data and generate plots
     if (SAVE_DATA) {
         cout << "\n==================================" << endl;
@@ -360,6 +567,12 @@ int main() {
         
         save_data_and_plot(p_zoonotic, "P(Sickness from Zoonotic Origin)");
         plot_paths.push_back("P_Sickness_from_Zoonotic_Origin_");
+
+        // Raw values above are draws under the biased proposal; they need these weights
+        if (weighted) {
+            save_data_and_plot({weights}, "Trial Weights");
+            plot_paths.push_back("Trial_Weights");
+        }
         
         cout << "\n==================================" << endl;
         cout << "All charts generated!" << endl;
@@ -386,7 +599,8 @@ int main() {
         html << "<div class='info'>\n";
         html << "<p><strong>Dataset:</strong> " << DATASET_DESC << "</p>\n";
         html << "<p><strong>Motion Model:</strong> " << MOTION_MODEL_DESC << "</p>\n";
-        html << "<p><strong>Number of Trials:</strong> " << NUM_TRIALS << "</p>\n";
+        html << "<p><strong>Animal Motion Model:</strong> " << ANIMAL_MOTION_MODEL_DESC << "</p>\n";
+        html << "<p><strong>Number of Trials:</strong> " << num_trials << "</p>\n";
         html << "<p><strong>Number of Humans:</strong> " << num_humans << "</p>\n";
         html << "<p><strong>Timestamp:</strong> " << GLOBAL_DESC << "</p>\n";
         html << "</div>\n";
@@ -426,4 +640,81 @@ int main() {
     
     return 0;
 }
+
+static int run_shard(uint64_t run_seed, int shard, int num_shards, const string& out_path) {
+    int first = static_cast<int>(static_cast<long>(TOTAL_TRIALS) * shard / num_shards);
+    int last = static_cast<int>(static_cast<long>(TOTAL_TRIALS) * (shard + 1) / num_shards);
+    cout << "Shard " << shard << "/" << num_shards << ": trials [" << first << ", " << last << ")" << endl;
+
+    vector<TrialResult> results = run_trials(run_seed, first, last - first, false);
+    if (!write_shard_results(out_path, first, results)) {
+        cerr << "Could not write shard results to " << out_path << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    cout << "**ZV-Sim**" << endl;
+
+    uint64_t run_seed = COMMON_RANDOM_NUMBERS ? BASE_SEED : derive_seed(BASE_SEED, GLOBAL_DESC);
+
+    // --shards K             drive K local shard processes and merge their results
+    // --shard k --of K --out path [--seed S]   run one shard (spawned by the driver)
+    int num_shards = 0, shard = -1;
+    bool shard_given = false, shard_count_given = false;
+    string out_path;
+    for (int i = 1; i < argc; i += 2) {
+        string flag = argv[i];
+        if (i + 1 == argc) {
+            cerr << "Missing value for option: " << flag << endl;
+            return 1;
+        }
+        string value = argv[i + 1];
+        try {
+            if (flag == "--shards") num_shards = stoi(value);
+            else if (flag == "--shard") { shard = stoi(value); shard_given = true; }
+            else if (flag == "--of") { num_shards = stoi(value); shard_count_given = true; }
+            else if (flag == "--out") out_path = value;
+            else if (flag == "--seed") run_seed = stoull(value);
+            else {
+                cerr << "Unknown option: " << flag << endl;
+                return 1;
+            }
+        } catch (const exception&) {
+            cerr << "Invalid value for " << flag << ": " << value << endl;
+            return 1;
+        }
+    }
+    if (num_shards < 0) {
+        cerr << "Shard count must not be negative" << endl;
+        return 1;
+    }
+    if (shard_given && (!shard_count_given || shard < 0 || shard >= num_shards || out_path.empty())) {
+        cerr << "--shard k needs --of K with 0 <= k < K, and --out path" << endl;
+        return 1;
+    }
+
+    try {
+        if (shard_given) {
+            return run_shard(run_seed, shard, num_shards, out_path);
+        }
+
+        vector<TrialResult> all_results;
+        if (num_shards > 0) {
+            string shard_dir = "data/" + DATASET_DESC + "/" + MOTION_MODEL_DESC + "/shards_" + to_string(GLOBAL_DESC);
+            cout << "Running " << TOTAL_TRIALS << " trials in " << num_shards << " shard processes..." << endl;
+            if (!run_sharded(argv[0], num_shards, run_seed, shard_dir, all_results)) {
+                return 1;
+            }
+        } else {
+            cout << "Running " << (ADAPTIVE_STOPPING ? "up to " : "") << TOTAL_TRIALS << " trials..." << endl;
+            all_results = run_trials(run_seed, 0, TOTAL_TRIALS, ADAPTIVE_STOPPING);
+        }
+        return report_results(all_results);
+    } catch (const exception& e) {
+        cerr << "Error in trial: " << e.what() << endl;
+        return 1;
+    }
+}
 #endif
\ No newline at end of file
@@ -4,14 +4,60 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <memory>
+#include <climits>
+#include "random.h"
+#include "motion.h"
+#include "infection.h"
+#include "hazard_field.h"
+#include "animal_bvh.h"
+#include "contact_graph.h"
+#include "human_grid.h"
+#include "domain.h"
 
 // Forward declarations
+enum class HumanStatus;
 class Human;
 class AnimalPresence;
+struct SimulationSnapshot;
+class Display;
+class Simulation;
+class WorkStealingPool;
+
+// Compiled tick for one combination of model policies (see engine.h)
+struct SimulationEngine {
+    void (*tick)(Simulation& sim) = nullptr;
+    bool random_animal_motion = false;  // animals draw motion noise on every non-keyframe tick
+};
+
+// What other humans may read of a human during the update phase of a tick. Published once
+// per tick after motion, so position and status are this tick's (motion applies the tick's
+// self-reports to status); output_hazard and last_onset are as the previous tick's update
+// phase left them. A human's own update only writes its own Human object, so the update
+// phase does not depend on iteration order and can run in parallel.
+struct HumanTickState {
+    int index;  // dense index of the human (see Simulation::human_order)
+    float x;
+    float y;
+    HumanStatus status;
+    float output_hazard;
+    int last_onset;  // start of the latest sickness record, INT_MIN if none
+};
 
 // --- Simulation Constants ---
-const int GRID_WIDTH = 600;
+const int GRID_WIDTH = 600;   // display size in pixels
 const int GRID_HEIGHT = 600;
+
+// Rectangle of model coordinates the display shows (grid units, projected metres, ...).
+// Nothing in the simulation is bounded by it: agents may be anywhere, and every spatial
+// index hashes its cells, so memory follows the occupied area only.
+struct WorldView {
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+};
 const double SIM_TICK_TIME_SECONDS = 10.0;
 const double STOP_SIM_AFTER = 600.0;
 
@@ -26,23 +72,88 @@ struct SimulationHumanResult {
     double sickness_p_zoonotic = 0.0;
 };
 
+// Per-human metrics reported by the trial engine
+enum class Metric {
+    SECONDARY_CASES = 0,
+    ANIMAL_HAZARD = 1,
+    HUMAN_HAZARD = 2,
+    P_ZOONOTIC = 3
+};
+const int NUM_METRICS = 4;
+extern const char* METRIC_NAMES[NUM_METRICS];
+double metric_value(const SimulationHumanResult& r, Metric m);
+
+// One trial's results, one per human in dense index order. ids maps an index back to the
+// human's external id and is shared by every trial of the same population. weight is the
+// trial's likelihood ratio (1 unless importance sampling biased its draws); estimators
+// average weight * value.
+struct TrialResult {
+    std::shared_ptr<const std::vector<int>> ids;
+    std::vector<SimulationHumanResult> humans;
+    double weight = 1.0;
+    ContactGraphSummary contact_graph;  // only when the trial recorded its contacts
+};
+
 class Simulation {
 public:
-    Simulation();
+    Simulation(uint64_t seed = 0);
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
 
-    void add_agent(void* agent);  
+    void add_agent(std::unique_ptr<Human> human);
+    void add_agent(std::unique_ptr<AnimalPresence> animal);
     void update();
+    void clear_agents();
     void print_results() const;
-    std::map<int, SimulationHumanResult> get_results() const;
+    TrialResult get_results() const;
     double get_current_real_time() const;
 
+    // Full-state checkpointing (see checkpoint.h)
+    SimulationSnapshot snapshot() const;
+    void restore(const SimulationSnapshot& snap);
+
     int time_step;
+    SimRandom rng;
+    double log_likelihood_ratio;  // accumulated by biased (importance-sampled) draws
+    bool long_horizon;            // prune history outside the analysis window every tick (see history.h)
+    bool record_contacts;         // append every closed human contact to contact_events (see contact_graph.h)
+    SimulationEngine engine;  // compiled policy combination run by update()
+    WorkStealingPool* tick_pool;  // splits the human update phase across threads (nullptr = serial)
+
+    // The simulation owns its agents
+    std::map<int, std::unique_ptr<Human>> human_agents; 
+    std::vector<std::unique_ptr<AnimalPresence>> animal_agents;
+    // Whole-trial contact stream, kept regardless of long_horizon pruning
+    std::vector<ContactEvent> contact_events;
+
+    // Humans in id order, so a human's position here is its dense index (Human::index), and
+    // the external id of each index. Assigned when the population changes; agents are added
+    // before the first tick, since contact records hold indices (see index_humans).
+    std::vector<Human*> human_order;
+    std::shared_ptr<const std::vector<int>> human_ids;
+    bool humans_indexed;
+    // Front buffer of the update phase, by dense index, with a grid over it for proximity
+    // queries (rebuilt every tick, see engine.h)
+    std::vector<HumanTickState> human_front;
+    HumanGrid human_grid;
+    // Tiled update phase with halo exchange (nullptr = one world-wide view, see domain.h)
+    std::unique_ptr<DomainDecomposition> domain;
+    const HumanTickState& published_state(int index) const { return this->human_front[index]; }
 
-    std::map<int, Human*> human_agents; 
-    std::vector<AnimalPresence*> animal_agents;
+    // Motion kernel scratch, reused every tick
+    MotionBatch human_batch;
+    MotionBatch animal_batch;
+    // Infection step scratch: contact pairs per contact-phase task, and the hazard columns
+    std::vector<ContactPairs> contact_pairs;
+    InfectionBatch infection_batch;
+    // Animal contact indexes (the engine refreshes the one it uses each tick after motion)
+    HazardField hazard_field;
+    AnimalBVH animal_bvh;
 };
 
-std::map<int, SimulationHumanResult> trial();
+void load_dataset(Simulation& sim);
+void run_to_end(Simulation& sim, Display* display = nullptr);
+TrialResult trial(const SimRandom& rng);
 void save_data(const std::vector<std::vector<double>>& data, const std::string& value);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,18 @@
+#include "snapshot.h"
+#include "agents.h"
+#include "simulator.h"
+
+void FrameSnapshot::capture(const Simulation& sim) {
+    this->time_step = sim.time_step;
+    this->real_time = sim.get_current_real_time();
+
+    this->humans.clear();
+    for (const auto& [id, h] : sim.human_agents) {
+        this->humans.push_back(AgentSnapshot{id, h->location.x, h->location.y, 5.0f, h->status});
+    }
+
+    this->animals.clear();
+    for (const auto& a : sim.animal_agents) {
+        this->animals.push_back(AgentSnapshot{a->id, a->location.x, a->location.y, a->radius, HumanStatus::HEALTHY});
+    }
+}
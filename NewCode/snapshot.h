@@ -0,0 +1,111 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "agents.h"
+
+// --- Immutable per-tick view of the world handed to consumers (display, capture) ---
+struct AgentSnapshot {
+    int id;
+    float x;
+    float y;
+    float radius;
+    HumanStatus status;
+};
+
+struct FrameSnapshot {
+    int time_step = 0;
+    double real_time = 0.0;
+    std::vector<AgentSnapshot> humans;
+    std::vector<AgentSnapshot> animals;
+
+    // Refill from the simulation in place (vector capacity is reused between ticks)
+    void capture(const Simulation& sim);
+};
+
+// Lock-free single-producer/single-consumer "latest value" buffer (triple buffering).
+// The producer always owns one slot, the consumer owns another, and the third is the
+// hand-off slot swapped atomically. Neither side ever waits on the other; the consumer
+// simply sees the most recently published value and skips anything older.
+template <typename T>
+class SnapshotBuffer {
+public:
+    SnapshotBuffer() : back(0), middle(1), front(2) {}
+
+    // Producer side: fill write_slot() and then call publish()
+    T& write_slot() {
+        return slots[back];
+    }
+
+    void publish() {
+        int prev = middle.exchange(back | DIRTY_BIT, std::memory_order_acq_rel);
+        back = prev & INDEX_MASK;
+    }
+
+    // Consumer side: returns true if a newer value was swapped into read_slot()
+    bool acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & DIRTY_BIT)) {
+            return false;
+        }
+        int prev = middle.exchange(front, std::memory_order_acq_rel);
+        front = prev & INDEX_MASK;
+        return true;
+    }
+
+    const T& read_slot() const {
+        return slots[front];
+    }
+
+private:
+    static const int DIRTY_BIT = 4;
+    static const int INDEX_MASK = 3;
+
+    T slots[3];
+    int back;                 // producer-owned
+    std::atomic<int> middle;  // shared hand-off slot index (+ dirty bit)
+    int front;                // consumer-owned
+};
+
+// Lock-free bounded single-producer/single-consumer queue used when every published
+// value matters (frame capture). Slots are preallocated and filled in place, so the
+// producer never allocates and never blocks: a full ring just reports failure.
+template <typename T, size_t N>
+class SnapshotRing {
+public:
+    SnapshotRing() : head(0), tail(0) {}
+
+    // Producer side: returns nullptr when the ring is full
+    T* try_begin_push() {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) {
+            return nullptr;
+        }
+        return &slots[t % N];
+    }
+
+    void commit_push() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer side: returns nullptr when the ring is empty
+    T* peek() {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[h % N];
+    }
+
+    void pop() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    T slots[N];
+    std::atomic<size_t> head;  // consumer-owned
+    std::atomic<size_t> tail;  // producer-owned
+};
+
+#endif //snapshot
@@ -0,0 +1,80 @@
+#include "stats.h"
+#include <cmath>
+
+void RunningStats::add(double x) {
+    this->count++;
+    double delta = x - this->mean;
+    this->mean += delta / static_cast<double>(this->count);
+    this->m2 += delta * (x - this->mean);
+}
+
+double RunningStats::variance() const {
+    if (this->count < 2) return 0.0;
+    return this->m2 / static_cast<double>(this->count - 1);
+}
+
+double RunningStats::standard_error() const {
+    if (this->count < 1) return 0.0;
+    return std::sqrt(this->variance() / static_cast<double>(this->count));
+}
+
+MetricSummary summarize_metric(const std::vector<double>& values, const std::vector<double>& weights,
+                               bool antithetic_pairs) {
+    MetricSummary summary;
+    size_t n = values.size();
+    // Mirrored trials only count as whole pairs: an unpaired last trial is left out of the mean
+    // as well as the standard error, so both describe the same sample
+    if (antithetic_pairs) n -= n % 2;
+    auto weight = [&](size_t i) { return weights.empty() ? 1.0 : weights[i]; };
+
+    RunningStats weighted;
+    for (size_t i = 0; i < n; ++i) weighted.add(weight(i) * values[i]);
+
+    summary.mean = weighted.mean;
+    summary.effective_sample_size = static_cast<double>(n);
+
+    // The standard error comes from independent samples: pair means with antithetic pairs,
+    // single trials otherwise, and needs at least two of them
+    if (antithetic_pairs) {
+        RunningStats pair_means;
+        for (size_t i = 0; i + 1 < n; i += 2) {
+            pair_means.add(0.5 * (weight(i) * values[i] + weight(i + 1) * values[i + 1]));
+        }
+        if (pair_means.count < 2) return summary;
+        summary.standard_error = pair_means.standard_error();
+    } else {
+        if (weighted.count < 2) return summary;
+        summary.standard_error = weighted.standard_error();
+    }
+    summary.has_standard_error = true;
+    if (!antithetic_pairs && weights.empty()) {
+        return summary;
+    }
+
+    // Variance of a single unweighted trial, estimated from the weighted sample
+    double sum_w = 0.0, sum_w_sq_dev = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double dev = values[i] - summary.mean;
+        sum_w += weight(i);
+        sum_w_sq_dev += weight(i) * dev * dev;
+    }
+    if (sum_w <= 0.0) {
+        return summary;
+    }
+    double trial_variance = sum_w_sq_dev / sum_w * static_cast<double>(n) / static_cast<double>(n - 1);
+    double estimator_variance = summary.standard_error * summary.standard_error;
+    if (estimator_variance > 0.0) {
+        summary.effective_sample_size = trial_variance / estimator_variance;
+    }
+    return summary;
+}
+
+double weight_effective_sample_size(const std::vector<double>& weights) {
+    double sum = 0.0, sum_sq = 0.0;
+    for (double w : weights) {
+        sum += w;
+        sum_sq += w * w;
+    }
+    if (sum_sq <= 0.0) return 0.0;
+    return sum * sum / sum_sq;
+}
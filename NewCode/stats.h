@@ -0,0 +1,37 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstdint>
+#include <vector>
+
+// Streaming mean/variance (Welford)
+class RunningStats {
+public:
+    int64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    void add(double x);
+    double variance() const;       // sample variance
+    double standard_error() const;
+};
+
+// Monte Carlo summary of one metric for one human across trials
+struct MetricSummary {
+    double mean = 0.0;
+    double standard_error = 0.0;
+    bool has_standard_error = false;  // false with fewer than two independent samples (trials, or pairs)
+    double effective_sample_size = 0.0;
+};
+
+// values[i] is trial i and weights[i] its likelihood ratio (empty = all 1); the estimator is the
+// mean of weight * value. With antithetic_pairs, trials (2k, 2k+1) are a mirrored pair and the
+// estimator averages pair means (an unpaired last trial is ignored). The effective sample size
+// is the number of independent, unweighted trials that would give the same standard error.
+MetricSummary summarize_metric(const std::vector<double>& values, const std::vector<double>& weights,
+                               bool antithetic_pairs);
+
+// Kish effective sample size of a set of importance weights: (sum w)^2 / sum w^2
+double weight_effective_sample_size(const std::vector<double>& weights);
+
+#endif //stats
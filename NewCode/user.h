@@ -6,20 +6,19 @@
 #include <cmath>
 #include <string>
 #include <random>
-#include "agents.h"
 #include "probability.h"
 
 class AnimalPresence;
 class Human;
 class HumanSicknessRecord;
+class Simulation;
 
 namespace user {
 extern const float HAZARD_DECAY;
 extern const float HUMAN_HAZARD_HEALTHY;
 extern const float HUMAN_HAZARD_SICK;
 
-void human_motion(Human* human, int current_time);
-void animal_motion(AnimalPresence* animal);
+// Motion models are the batched kernels in motion.h, chosen by name when the engine is selected
 float zoonotic_probability_model(HumanSicknessRecord* sickness_record);
 
 class InfectionModel {
@@ -28,25 +27,23 @@ public:
     float experienced_animal_hazard;
     float experienced_human_hazard;
 
+    InfectionModel();
     InfectionModel(float output_hazard, float experienced_animal_hazard, float experienced_human_hazard);
-    InfectionModel(const InfectionModel& other);
 
-    float total_experienced_hazard();
-    std::string __str__();
+    float total_experienced_hazard() const;
+    std::string __str__() const;
 };
 
 extern bool SIMULATE_SPREAD;
+// Importance sampling: infection draws of healthy humans use the animal hazard scaled by this
+// factor (1 = plain sampling), and each biased draw multiplies the trial weight by p/q
+extern float IMPORTANCE_ANIMAL_HAZARD_TILT;
 extern const float HUMAN_HAZARD_HEALTHY;
 extern const float HUMAN_HAZARD_SICK;
 extern const float HA;
 
 
-
-bool infection_probability_model(
-    Human* human,
-    const std::vector<AnimalPresence*>& animal_contacts, 
-    const std::vector<Human*>& human_contacts   
-);
+// The infection model is the batched kernels in infection.h, driven by the hazard constants above
 
 } 
 